@@ -95,6 +95,24 @@ if (arity == fixed + {n}) \{
 }
 }\n"
 
+/-- Like `lean_apply_{n}`, but `f` is borrowed: saturating applications skip the `lean_inc`/`lean_dec_ref` of `f`. -/
+def mkApplyBorrowedI (n : Nat) (max : Nat) : M Unit := do
+  let argDecls := mkArgDecls n
+  let args := mkArgs n
+  emit s!"extern \"C\" LEAN_EXPORT obj* lean_apply_borrowed_{n}(obj* f, {argDecls}) \{
+if (!lean_is_scalar(f) && lean_closure_arity(f) == lean_closure_num_fixed(f) + {n}) \{
+  switch (lean_closure_arity(f)) \{\n"
+  for j in [n:max + 1] do
+    let lean_incfs := mkIncFs (j - n)
+    let fs := mkFsArgs (j - n)
+    let sep := if j = n then "" else ", "
+    emit s!"  case {j}: \{ {lean_incfs}return FN{j}(f)({fs}{sep}{args}); }\n"
+  emit s!"  }
+}
+lean_inc(f);
+return lean_apply_{n}(f, {args});
+}\n"
+
 def mkCurry (max : Nat) : M Unit := do
   emit "obj* curry(void* f, unsigned n, obj** as) {
 switch (n) {
@@ -144,21 +162,43 @@ if (arity == fixed + n) \{
 }\n"
 
 def mkFixArgs : M Unit := emit "
+/* Partial applications created here reserve room for `arity - 1` fixed arguments (up to `LEAN_CLOSURE_MAX_ARGS`),
+   so that applying an unshared one to further, non-saturating arguments can store them in place.
+   Closures are released with `lean_free_small_object`, and `lean_small_object_size` reports the reserved size. */
+static obj* alloc_pap(void* fun, unsigned arity, unsigned num_fixed) {
+    unsigned capacity = arity <= LEAN_CLOSURE_MAX_ARGS ? arity - 1 : num_fixed;
+    lean_closure_object * o = (lean_closure_object*)lean_alloc_small_object(sizeof(lean_closure_object) + sizeof(void*)*capacity);
+    lean_set_st_header((obj*)o, LeanClosure, 0);
+    o->m_fun = fun;
+    o->m_arity = arity;
+    o->m_num_fixed = num_fixed;
+    return (obj*)o;
+}
+
 static obj* fix_args(obj* f, unsigned n, obj*const* as) {
     unsigned arity = lean_closure_arity(f);
     unsigned fixed = lean_closure_num_fixed(f);
     unsigned new_fixed = fixed + n;
     lean_assert(new_fixed < arity);
-    obj * r = lean_alloc_closure(lean_closure_fun(f), arity, new_fixed);
-    obj ** source = lean_closure_arg_cptr(f);
-    obj ** target = lean_closure_arg_cptr(r);
+    obj * r;
+    obj ** target;
     if (!lean_is_exclusive(f)) {
+      r = alloc_pap(lean_closure_fun(f), arity, new_fixed);
+      obj ** source = lean_closure_arg_cptr(f);
+      target = lean_closure_arg_cptr(r);
       for (unsigned i = 0; i < fixed; i++, source++, target++) {
           *target = *source;
           lean_inc(*target);
       }
       lean_dec_ref(f);
+    } else if (lean_small_object_size(f) >= sizeof(lean_closure_object) + sizeof(void*)*new_fixed) {
+      r = f;
+      lean_to_closure(r)->m_num_fixed = new_fixed;
+      target = lean_closure_arg_cptr(r) + fixed;
     } else {
+      r = alloc_pap(lean_closure_fun(f), arity, new_fixed);
+      obj ** source = lean_closure_arg_cptr(f);
+      target = lean_closure_arg_cptr(r);
       for (unsigned i = 0; i < fixed; i++, source++, target++) {
           *target = *source;
       }
@@ -198,6 +238,7 @@ namespace lean {
   mkCurry max
   emit "extern \"C\" obj* lean_apply_n(obj*, unsigned, obj**);\n"
   for i in [0:max] do mkApplyI (i+1) max
+  for i in [0:max] do mkApplyBorrowedI (i+1) max
   mkApplyM max
   mkApplyN max
   emit "}\n"
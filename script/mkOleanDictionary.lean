@@ -0,0 +1,43 @@
+import Lean.Environment
+import Lean.Util.FoldConsts
+
+/-!
+
+Usage:
+```sh
+lean --run ./script/mkOleanDictionary.lean dict.olean path/to/*.olean
+```
+
+Builds a shared object dictionary (see `Lean.saveOleanDictionary`) from the given `.olean` files. The
+dictionary contains the names used by the constants of at least `minModules` of the files, together
+with their prefixes. Setting `LEAN_OLEAN_DICTIONARY=dict.olean` when building these modules again
+makes their `.olean` files reference the dictionary's copies of these names instead of storing
+their own. The files given here must not themselves reference a dictionary.
+-/
+
+open Lean
+
+/-- Minimal number of modules using a name for it to be included in the dictionary. -/
+def minModules := 2
+
+def collectNames (mod : ModuleData) : NameSet :=
+  mod.constants.foldl (init := {}) fun s c => c.getUsedConstantsAsSet.fold (·.insert ·) (s.insert c.name)
+
+unsafe def mkDictionary (out : System.FilePath) (oleans : List System.FilePath) : IO Unit := do
+  let mut counts : HashMap Name Nat := {}
+  for fname in oleans do
+    -- the regions are not freed as the names are still referenced below
+    let (mod, _) ← readModuleData fname
+    counts := (collectNames mod).fold (init := counts) fun counts n => counts.insert n (counts.findD n 0 + 1)
+  let names := counts.fold (init := #[]) fun ns n k =>
+    if k ≥ minModules && !n.isAnonymous then ns.push (unsafeCast n : NonScalar) else ns
+  saveOleanDictionary out names
+  IO.println s!"{out}: {names.size} names"
+
+def main : List String → IO UInt32
+  | out :: oleans => do
+    unsafe mkDictionary out (oleans.map (⟨·⟩))
+    return 0
+  | [] => do
+    IO.eprintln "usage: mkOleanDictionary.lean <out.olean> <.olean files>..."
+    return 1
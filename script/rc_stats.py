@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+#
+# Static reference counting statistics of C code generated by the Lean compiler.
+#
+# Usage: script/rc_stats.py stage0/stdlib
+#
+# Prints the number of `lean_inc*`/`lean_dec*` calls, the number of `lean_inc(f); ... lean_apply_<n>(f, ...)`
+# pairs that `EmitC` emits as `lean_apply_borrowed_<n>(f, ...)`, and the RC operations that inferring closure
+# parameters that are only applied as borrowed would remove and add.
+
+import collections
+import os
+import re
+import sys
+
+RC = re.compile(r'\blean_(inc|dec)(_ref)?(_n)?\(')
+INC = re.compile(r'^lean_inc(?:_ref)?\((x_\d+)\);$')
+APPLY = re.compile(r'^(x_\d+) = lean_apply_(\d+)\((x_\d+)(.*)\);$')
+FN = re.compile(r'^(?:LEAN_EXPORT |static )?(?:lean_object\*|uint\d+_t|double|size_t) (l_\w+)\(([^)]*)\) \{$')
+CALL = re.compile(r'\b(l_\w+)\(')
+CLOSURE_MAX_ARGS = 16
+
+def c_files(root):
+    for d, _, fs in os.walk(root):
+        for f in fs:
+            if f.endswith('.c'):
+                yield os.path.join(d, f)
+
+def is_inc_of(line, x):
+    return re.match(r'^lean_inc(_ref)?\(%s\);$' % x, line) is not None
+
+def is_dec_of(line, x):
+    return re.match(r'^lean_dec(_ref)?\(%s\);$' % x, line) is not None
+
+def only_applied(fn, params, idx, body):
+    """Is parameter `idx` of `fn` only applied, released, or passed on at the same position of a recursive call?"""
+    p = params[idx]
+    occ = re.compile(r'\b%s\b' % p)
+    applied = False
+    for l in body:
+        if not occ.search(l) or is_inc_of(l, p) or is_dec_of(l, p):
+            continue
+        if re.match(r'^x_\d+ = lean_apply_\d+\(%s,' % p, l) and len(occ.findall(l)) == 1:
+            applied = True
+            continue
+        m = re.match(r'^(?:x_\d+ = |return )?%s\((.*)\);$' % fn, l)
+        if m:
+            args = [a.strip() for a in m.group(1).split(',')]
+            if args.count(p) == 1 and args.index(p) == idx:
+                continue
+        return False
+    return applied
+
+def main(root):
+    num_files = num_inc = num_dec = num_borrowed_apps = 0
+    fns = {}
+    for path in c_files(root):
+        num_files += 1
+        lines = open(path, encoding='utf-8', errors='replace').read().split('\n')
+        cur = None
+        for i, l in enumerate(lines):
+            for m in RC.finditer(l):
+                if m.group(1) == 'inc':
+                    num_inc += 1
+                else:
+                    num_dec += 1
+            m = FN.match(l)
+            if m:
+                params = [p.split()[-1] for p in m.group(2).split(',')] if m.group(2) else []
+                cur = fns[m.group(1)] = (params, [])
+                continue
+            if cur is not None:
+                if l == '}':
+                    cur = None
+                else:
+                    cur[1].append(l)
+            m = INC.match(l)
+            if m:
+                # see `EmitC.isBorrowedApp`
+                x = m.group(1)
+                j = i + 1
+                while j < len(lines) and INC.match(lines[j]) and INC.match(lines[j]).group(1) != x:
+                    j += 1
+                a = APPLY.match(lines[j]) if j < len(lines) else None
+                if a and a.group(3) == x and int(a.group(2)) <= CLOSURE_MAX_ARGS and not re.search(r'\b%s\b' % x, a.group(4)):
+                    num_borrowed_apps += 1
+
+    only_applied_params = collections.defaultdict(set)
+    for fn, (params, body) in fns.items():
+        for idx, p in enumerate(params):
+            if p.startswith('x_') and only_applied(fn, params, idx, body):
+                only_applied_params[fn].add(idx)
+    callee_decs = sum(1 for fn, idxs in only_applied_params.items() for idx in idxs
+                      for l in fns[fn][1] if is_dec_of(l, fns[fn][0][idx]))
+    call_sites = caller_incs = caller_decs = 0
+    for fn, (params, body) in fns.items():
+        for i, l in enumerate(body):
+            for m in CALL.finditer(l):
+                callee = m.group(1)
+                if callee == fn or callee not in only_applied_params:
+                    continue
+                call_sites += 1
+                args = [a.strip() for a in l[m.end():].split(')')[0].split(',')]
+                for idx in only_applied_params[callee]:
+                    if idx >= len(args) or not args[idx].startswith('x_'):
+                        continue
+                    if any(is_inc_of(q, args[idx]) for q in body[max(0, i - 12):i]):
+                        # the caller keeps the closure, and no longer needs to increment it
+                        caller_incs += 1
+                    elif args[idx] not in params:
+                        # the caller passes its last reference, and now has to release it after the call
+                        caller_decs += 1
+
+    print("files: %d" % num_files)
+    print("lean_inc* calls: %d, lean_dec* calls: %d" % (num_inc, num_dec))
+    print("lean_inc + lean_apply_<n> pairs: %d" % num_borrowed_apps)
+    print("functions with closure parameters that are only applied: %d (%d parameters, %d call sites)"
+          % (len(only_applied_params), sum(len(s) for s in only_applied_params.values()), call_sites))
+    print("borrowing them removes %d lean_dec in callees and %d lean_inc in callers, and adds %d lean_dec in callers"
+          % (callee_decs, caller_incs, caller_decs))
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        print("usage: rc_stats.py <directory of generated C files>")
+        sys.exit(1)
+    main(sys.argv[1])
@@ -176,7 +176,7 @@ section repr_toString
 
 /-- Convert bitvector into a fixed-width hex number. -/
 protected def toHex {n : Nat} (x : BitVec n) : String :=
-  let s := (Nat.toDigits 16 x.toNat).asString
+  let s := x.toNat.toHexString
   let t := (List.replicate ((n+3) / 4 - s.length) '0').asString
   t ++ s
 
@@ -96,6 +96,22 @@ protected def append (a : ByteArray) (b : ByteArray) : ByteArray :=
 
 instance : Append ByteArray := ⟨ByteArray.append⟩
 
+@[extern "lean_byte_array_beq"]
+protected def beq (a b : @& ByteArray) : Bool :=
+  a.data == b.data
+
+instance : BEq ByteArray := ⟨ByteArray.beq⟩
+
+/-- Sets the bytes at `[off, off + len)` in `a` to `v`, ignoring positions past the end of `a`. -/
+@[extern "lean_byte_array_fill"]
+def fill (a : ByteArray) (v : UInt8) (off len : @& Nat) : ByteArray :=
+  ⟨a.data.mapIdx fun i x => if off ≤ i.1 ∧ i.1 < off + len then v else x⟩
+
+/-- Replaces `a[i]` with `a[i] ^^^ b[i]` for every `i < min a.size b.size`. -/
+@[extern "lean_byte_array_xor"]
+protected def xor (a : ByteArray) (b : @& ByteArray) : ByteArray :=
+  ⟨a.data.mapIdx fun i x => x ^^^ b.data.getD i.1 0⟩
+
 def toList (bs : ByteArray) : List UInt8 :=
   let rec loop (i : Nat) (r : List UInt8) :=
     if i < bs.size then
@@ -116,6 +132,13 @@ def toList (bs : ByteArray) : List UInt8 :=
     decreasing_by decreasing_trivial_pre_omega
   loop start
 
+/--
+  Returns the index of the first occurrence of `b` in `a` at or after `start`.
+  Implemented using `memchr` by the runtime. -/
+@[extern "lean_byte_array_index_of"]
+def indexOf? (a : @& ByteArray) (b : UInt8) (start : @& Nat := 0) : Option Nat :=
+  a.findIdx? (· == b) start
+
 /--
   We claim this unsafe implementation is correct because an array cannot have more than `usizeSz` elements in our runtime.
   This is similar to the `Array` version.
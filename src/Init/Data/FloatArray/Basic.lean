@@ -80,6 +80,26 @@ def set! : FloatArray → (@& Nat) → Float → FloatArray
 def isEmpty (s : FloatArray) : Bool :=
   s.size == 0
 
+/-- Replaces `a[i]` with `a[i] + b[i]` for every `i < min a.size b.size`. -/
+@[extern "lean_float_array_add"]
+protected def add (a : FloatArray) (b : @& FloatArray) : FloatArray :=
+  ⟨a.data.mapIdx fun i x => if h : i.1 < b.size then x + b.get ⟨i.1, h⟩ else x⟩
+
+/-- Replaces `a[i]` with `a[i] * b[i]` for every `i < min a.size b.size`. -/
+@[extern "lean_float_array_mul"]
+protected def mul (a : FloatArray) (b : @& FloatArray) : FloatArray :=
+  ⟨a.data.mapIdx fun i x => if h : i.1 < b.size then x * b.get ⟨i.1, h⟩ else x⟩
+
+/-- Sum of the elements of `a`, added from left to right. -/
+@[extern "lean_float_array_sum"]
+def sum (a : @& FloatArray) : Float :=
+  a.data.foldl (· + ·) 0
+
+/-- Sum of `a[i] * b[i]` for `i < min a.size b.size`, added from left to right. -/
+@[extern "lean_float_array_dot"]
+def dot (a b : @& FloatArray) : Float :=
+  (Array.zipWith a.data b.data (· * ·)).foldl (· + ·) 0
+
 partial def toList (ds : FloatArray) : List Float :=
   let rec loop (i r) :=
     if h : i < ds.size then
@@ -151,6 +151,22 @@ def toDigitsCore (base : Nat) : Nat → Nat → List Char → List Char
 def toDigits (base : Nat) (n : Nat) : List Char :=
   toDigitsCore base (n+1) n []
 
+/--
+Returns the decimal representation of `n`, i.e., `(toDigits 10 n).asString`.
+Implemented natively, using divide-and-conquer radix conversion for big numbers.
+-/
+@[extern "lean_nat_to_decimal_string"]
+def toDecimalString (n : @& Nat) : String :=
+  (toDigits 10 n).asString
+
+/--
+Returns the hexadecimal representation of `n` using lowercase digits, i.e., `(toDigits 16 n).asString`.
+Implemented natively.
+-/
+@[extern "lean_nat_to_hex_string"]
+def toHexString (n : @& Nat) : String :=
+  (toDigits 16 n).asString
+
 @[extern "lean_string_of_usize"]
 protected def _root_.USize.repr (n : @& USize) : String :=
   (toDigits 10 n.toNat).asString
@@ -161,8 +177,7 @@ private def reprArray : Array String := Id.run do
 
 private def reprFast (n : Nat) : String :=
   if h : n < 128 then Nat.reprArray.get ⟨n, h⟩ else
-  if h : n < USize.size then (USize.ofNatCore n h).repr
-  else (toDigits 10 n).asString
+  n.toDecimalString
 
 @[implemented_by reprFast]
 protected def repr (n : Nat) : String :=
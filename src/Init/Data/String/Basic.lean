@@ -417,6 +417,29 @@ def firstDiffPos (a b : String) : Pos :=
     termination_by stopPos.1 - i.1
   loop 0
 
+/--
+Applies `String.next` `n` times to the position `p`.
+The runtime implementation skips ASCII text several bytes at a time.
+-/
+@[extern "lean_string_utf8_next_n"]
+def nextn : (@& String) → (@& Pos) → (@& Nat) → Pos
+  | _, p, 0   => p
+  | s, p, n+1 => nextn s (s.next p) n
+
+/--
+Returns the number of times `String.next` has to be applied to `b` to reach `e` or the end of `s`.
+If `b ≤ e` are valid positions, this is the number of characters in `s.extract b e`.
+The runtime implementation skips ASCII text several bytes at a time.
+-/
+@[extern "lean_string_utf8_count"]
+def countChars (s : @& String) (b e : @& Pos) : Nat :=
+  if b == e then 0
+  else if h : b < s.endPos then
+    have := Nat.sub_lt_sub_left h (lt_next s b)
+    countChars s (s.next b) e + 1
+  else 0
+termination_by s.endPos.1 - b.1
+
 @[extern "lean_string_utf8_extract"]
 def extract : (@& String) → (@& Pos) → (@& Pos) → String
   | ⟨s⟩, b, e => if b.byteIdx ≥ e.byteIdx then "" else ⟨go₁ s 0 b e⟩
@@ -515,18 +538,25 @@ instance : Append String := ⟨String.append⟩
 @[deprecated push (since := "2024-04-06")]
 def str : String → Char → String := push
 
-def pushn (s : String) (c : Char) (n : Nat) : String :=
+/-- Appends `n` copies of `c` to `s`. -/
+@[extern "lean_string_pushn"]
+def pushn (s : String) (c : Char) (n : @& Nat) : String :=
   n.repeat (fun s => s.push c) s
 
 def isEmpty (s : String) : Bool :=
   s.endPos == 0
 
-def join (l : List String) : String :=
+/-- Concatenates a list of strings. The result is allocated once, at its final size. -/
+@[extern "lean_string_join"]
+def join (l : @& List String) : String :=
   l.foldl (fun r s => r ++ s) ""
 
 def singleton (c : Char) : String :=
   "".push c
 
+/-- Concatenates a list of strings, with `s` inserted between consecutive elements.
+The result is allocated once, at its final size. -/
+@[extern "lean_string_intercalate"]
 def intercalate (s : String) : List String → String
   | []      => ""
   | a :: as => go a s as
@@ -773,7 +803,12 @@ termination_by s.endPos.1 - i.1
 def isNat (s : String) : Bool :=
   !s.isEmpty && s.all (·.isDigit)
 
-def toNat? (s : String) : Option Nat :=
+/--
+Interprets `s` as the decimal representation of a natural number, returning `none` if it is not one.
+Implemented natively, using divide-and-conquer radix conversion for big numbers.
+-/
+@[extern "lean_string_to_nat"]
+def toNat? (s : @& String) : Option Nat :=
   if s.isNat then
     some <| s.foldl (fun n c => n*10 + (c.toNat - '0'.toNat)) 0
   else
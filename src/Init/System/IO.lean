@@ -433,6 +433,16 @@ Note that EOF does not actually close a handle, so further reads may block and r
 @[extern "lean_io_prim_handle_get_line"] opaque getLine (h : @& Handle) : IO String
 @[extern "lean_io_prim_handle_put_str"] opaque putStr (h : @& Handle) (s : @& String) : IO Unit
 
+/--
+Read all remaining bytes from the handle, until an end-of-file marker is reached.
+The bytes are read directly into the resulting array, which is sized upfront if the handle refers to a regular file.
+-/
+@[extern "lean_io_prim_handle_read_bin_to_end"] opaque readBinToEnd (h : @& Handle) : IO ByteArray
+/--
+Like `readBinToEnd`, but returns the bytes as a string, or `none` if they are not valid UTF-8.
+-/
+@[extern "lean_io_prim_handle_read_to_end"] opaque readToEnd? (h : @& Handle) : IO (Option String)
+
 end Handle
 
 /--
@@ -479,12 +489,8 @@ partial def Handle.readBinToEndInto (h : Handle) (buf : ByteArray) : IO ByteArra
       loop (acc ++ buf)
   loop buf
 
-partial def Handle.readBinToEnd (h : Handle) : IO ByteArray := do
-  h.readBinToEndInto .empty
-
 def Handle.readToEnd (h : Handle) : IO String := do
-  let data ← h.readBinToEnd
-  match String.fromUTF8? data with
+  match (← h.readToEnd?) with
   | some s => return s
   | none => throw <| .userError s!"Tried to read from handle containing non UTF-8 data."
 
@@ -595,20 +601,12 @@ namespace IO
 namespace FS
 
 def readBinFile (fname : FilePath) : IO ByteArray := do
-  -- Requires metadata so defined after metadata
-  let mdata ← fname.metadata
-  let size := mdata.byteSize.toUSize
   let handle ← IO.FS.Handle.mk fname .read
-  let buf ←
-    if size > 0 then
-      handle.read mdata.byteSize.toUSize
-    else
-      pure <| ByteArray.mkEmpty 0
-  handle.readBinToEndInto buf
+  handle.readBinToEnd
 
 def readFile (fname : FilePath) : IO String := do
-  let data ← readBinFile fname
-  match String.fromUTF8? data with
+  let handle ← IO.FS.Handle.mk fname .read
+  match (← handle.readToEnd?) with
   | some s => return s
   | none => throw <| .userError s!"Tried to read file '{fname}' containing non UTF-8 data."
 
@@ -26,4 +26,13 @@ def getClosedTermName? (env : Environment) (e : Expr) : Option Name :=
 def isClosedTermName (env : Environment) (n : Name) : Bool :=
   (closedTermCacheExt.getState env).constNames.contains n
 
+/--
+Return `true` if `n` has the form `f._closed_<idx>` of the closed terms extracted by the compiler
+(see `mk_extract_closed_aux_fn`). Unlike `isClosedTermName`, this also works for imported closed
+terms, as the cache is not persisted. -/
+def isExtractClosedAuxFn (n : Name) : Bool :=
+  match n with
+  | .str p s => !p.isAnonymous && s.startsWith "_closed"
+  | _        => false
+
 end Lean
@@ -18,6 +18,7 @@ import Lean.Compiler.IR.Boxing
 import Lean.Compiler.IR.RC
 import Lean.Compiler.IR.ExpandResetReuse
 import Lean.Compiler.IR.UnboxResult
+import Lean.Compiler.IR.EscapeAnalysis
 import Lean.Compiler.IR.ElimDeadBranches
 import Lean.Compiler.IR.EmitC
 import Lean.Compiler.IR.CtorLayout
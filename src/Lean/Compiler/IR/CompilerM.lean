@@ -97,6 +97,44 @@ def findEnvDecl (env : Environment) (declName : Name) : Option Decl :=
   | some modIdx => findAtSorted? (declMapExt.getModuleEntries env modIdx) declName
   | none        => declMapExt.getState env |>.find? declName
 
+/--
+Like `findEnvDecl`, but only finds declarations of imported modules, which are the same in all environments derived
+from the same imports. -/
+@[export lean_ir_find_imported_env_decl]
+def findImportedEnvDecl (env : Environment) (declName : Name) : Option Decl := do
+  let modIdx ← env.getModuleIdxFor? declName
+  findAtSorted? (declMapExt.getModuleEntries env modIdx) declName
+
+private opaque InterpreterCacheImpl : NonemptyType.{0}
+
+/--
+Thread-safe cache of the IR interpreter for imported declarations: their IR, native symbols, and the values of closed
+constants it evaluated. Each environment created by `importModules` or `mkEmptyEnvironment` gets a fresh cache that is
+shared by all environments derived from it, so interpreter invocations for different commands do not have to repeat
+this work. Declarations added after the import are not cached.
+-/
+def InterpreterCache : Type := InterpreterCacheImpl.type
+
+instance : Nonempty InterpreterCache := InterpreterCacheImpl.property
+
+/-- Creates a new empty `InterpreterCache`. -/
+@[extern "lean_ir_mk_interpreter_cache"]
+opaque InterpreterCache.new : BaseIO InterpreterCache
+
+builtin_initialize interpreterCacheExt : EnvExtension (Option InterpreterCache) ←
+  registerEnvExtension (some <$> InterpreterCache.new)
+
+@[export lean_ir_get_interpreter_cache]
+def getInterpreterCache (env : Environment) : Option InterpreterCache :=
+  interpreterCacheExt.getState env
+
+/--
+Writes the call path profile collected by interpreters run with `interpreter.profile` set so far. The `lean` executable
+does so at exit; processes that end via `IO.Process.exit`, such as the server's file workers, have to call this first.
+-/
+@[extern "lean_ir_save_interpreter_profile"]
+opaque saveInterpreterProfile : IO Unit
+
 def findDecl (n : Name) : CompilerM (Option Decl) :=
   return findEnvDecl (← get).env n
 
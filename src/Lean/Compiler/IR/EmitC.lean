@@ -13,9 +13,22 @@ import Lean.Compiler.IR.EmitUtil
 import Lean.Compiler.IR.NormIds
 import Lean.Compiler.IR.SimpCase
 import Lean.Compiler.IR.Boxing
+import Lean.Compiler.IR.UnboxResult
+import Lean.Compiler.IR.EscapeAnalysis
 
 namespace Lean.IR.EmitC
 open ExplicitBoxing (requiresBoxedVersion mkBoxedName isBoxedName)
+open UnboxResult (isUnboxedName)
+
+register_builtin_option compiler.wholeProgram : Bool := {
+  defValue := false
+  descr    := "when generating C code for a module defining `main`, also emit private copies of the imported functions it (transitively) uses so that the C compiler can inline and specialize them"
+}
+
+register_builtin_option compiler.stackAlloc : Bool := {
+  defValue := true
+  descr    := "allocate constructor objects that do not escape their function on the C stack (closures are always heap allocated)"
+}
 
 def leanMainFn := "_lean_main"
 
@@ -23,14 +36,26 @@ structure Context where
   env        : Environment
   modName    : Name
   jpMap      : JPParamsMap := {}
+  varTypes   : VarTypeMap := {}
+  /-- Constructor objects of the current function allocated on the stack, see `EscapeAnalysis`. -/
+  stackCtors : HashMap VarId CtorInfo := {}
+  stackAlloc : Bool := false
   mainFn     : FunId := default
   mainParams : Array Param := #[]
+  /-- Imported functions emitted as `static` copies in whole-program mode, see `getCopiedDecls`. -/
+  copiedDecls : NameSet := {}
+  /-- The declarations of the module after `UnboxResult.unboxResults`. -/
+  decls      : Array Decl := #[]
+  declMap    : NameMap Decl := {}
 
 abbrev M := ReaderT Context (EStateM String String)
 
 def getEnv : M Environment := Context.env <$> read
 def getModName : M Name := Context.modName <$> read
+def isCopiedDecl (n : Name) : M Bool := return (← read).copiedDecls.contains n
 def getDecl (n : Name) : M Decl := do
+  if let some d := (← read).declMap.find? n then
+    return d
   let env ← getEnv
   match findEnvDecl env n with
   | some d => pure d
@@ -63,7 +88,7 @@ def toCType : IRType → String
   | IRType.object     => "lean_object*"
   | IRType.tobject    => "lean_object*"
   | IRType.irrelevant => "lean_object*"
-  | IRType.struct _ _ => panic! "not implemented yet"
+  | IRType.struct _ tys => s!"lean_ir_struct{tys.size}"
   | IRType.union _ _  => panic! "not implemented yet"
 
 def throwInvalidExportName {α : Type} (n : Name) : M α :=
@@ -106,6 +131,8 @@ def emitFnDeclAux (decl : Decl) (cppBaseName : String) (isExternal : Bool) : M U
     if isClosedTermName env decl.name then emit "static "
     else if isExternal then emit "extern "
     else emit "LEAN_EXPORT "
+  else if (← isCopiedDecl decl.name) || isUnboxedName decl.name then
+    emit "static "
   else
     if !isExternal && shouldExport decl.name then emit "LEAN_EXPORT "
   emit (toCType decl.resultType ++ " " ++ cppBaseName)
@@ -133,9 +160,11 @@ def emitExternDeclAux (decl : Decl) (cNameStr : String) : M Unit := do
 
 def emitFnDecls : M Unit := do
   let env ← getEnv
-  let decls := getDecls env
+  let decls := (← read).decls
   let modDecls  : NameSet := decls.foldl (fun s d => s.insert d.name) {}
   let usedDecls : NameSet := decls.foldl (fun s d => collectUsedDecls env d (s.insert d.name)) {}
+  let usedDecls ← (← read).copiedDecls.toList.foldlM (init := usedDecls) fun s n =>
+    return collectUsedDecls env (← getDecl n) (s.insert n)
   let usedDecls := usedDecls.toList
   usedDecls.forM fun n => do
     let decl ← getDecl n;
@@ -262,13 +291,20 @@ def declareVar (x : VarId) (t : IRType) : M Unit := do
 def declareParams (ps : Array Param) : M Unit :=
   ps.forM fun p => declareVar p.x p.ty
 
+/-- Declare the stack storage `x_s` of the constructor object `x`. -/
+def declareStackCtor (x : VarId) (c : CtorInfo) : M Unit := do
+  emit "lean_object* "; emit x; emit "_s[(sizeof(lean_ctor_object) + sizeof(void*)*"; emit c.size
+  emit " + sizeof(size_t)*"; emit c.usize; emit " + "; emit c.ssize; emit " + sizeof(void*) - 1)/sizeof(void*)]; "
+
 partial def declareVars : FnBody → Bool → M Bool
   | e@(FnBody.vdecl x t _ b), d => do
     let ctx ← read
     if isTailCallTo ctx.mainFn e then
       pure d
     else
-      declareVar x t; declareVars b true
+      declareVar x t
+      if let some c := ctx.stackCtors.find? x then declareStackCtor x c
+      declareVars b true
   | FnBody.jdecl _ xs _ b,    d => do declareParams xs; declareVars b (d || xs.size > 0)
   | e,                        d => if e.isTerminal then pure d else declareVars e.body d
 
@@ -298,6 +334,11 @@ def emitDec (x : VarId) (n : Nat) (checkRef : Bool) : M Unit := do
   if n != 1 then emit ", "; emit n
   emitLn ");"
 
+/-- Release the fields of the stack allocated constructor object `x` instead of `x` itself. -/
+def emitStackDec (x : VarId) (c : CtorInfo) : M Unit :=
+  c.size.forM fun i => do
+    emit "lean_dec(lean_ctor_get("; emit x; emit ", "; emit i; emitLn "));"
+
 def emitDel (x : VarId) : M Unit := do
   emit "lean_free_object("; emit x; emitLn ");"
 
@@ -357,7 +398,16 @@ def emitCtorSetArgs (z : VarId) (ys : Array Arg) : M Unit :=
   ys.size.forM fun i => do
     emit "lean_ctor_set("; emit z; emit ", "; emit i; emit ", "; emitArg ys[i]!; emitLn ");"
 
+def emitStructCtor (z : VarId) (ys : Array Arg) : M Unit :=
+  ys.size.forM fun i => do
+    emit z; emit ".f["; emit i; emit "] = "; emitArg ys[i]!; emitLn ";"
+
 def emitCtor (z : VarId) (c : CtorInfo) (ys : Array Arg) : M Unit := do
+  if (← read).stackCtors.contains z then
+    emitLhs z; emit "(lean_object*)"; emit z; emitLn "_s;"
+    emit "lean_set_non_heap_header("; emit z; emit ", sizeof("; emit z; emit "_s), "; emit c.cidx; emit ", "; emit c.size; emitLn ");"
+    emitCtorSetArgs z ys
+    return
   emitLhs z;
   if c.size == 0 && c.usize == 0 && c.ssize == 0 then do
     emit "lean_box("; emit c.cidx; emitLn ");"
@@ -383,8 +433,14 @@ def emitReuse (z : VarId) (x : VarId) (c : CtorInfo) (updtHeader : Bool) (ys : A
   emitLn "}";
   emitCtorSetArgs z ys
 
+def isStructVar (x : VarId) : M Bool :=
+  return ((← read).varTypes.find? x matches some (.struct ..))
+
 def emitProj (z : VarId) (i : Nat) (x : VarId) : M Unit := do
-  emitLhs z; emit "lean_ctor_get("; emit x; emit ", "; emit i; emitLn ");"
+  if (← isStructVar x) then
+    emitLhs z; emit x; emit ".f["; emit i; emitLn "];"
+  else
+    emitLhs z; emit "lean_ctor_get("; emit x; emit ", "; emit i; emitLn ");"
 
 def emitUProj (z : VarId) (i : Nat) (x : VarId) : M Unit := do
   emitLhs z; emit "lean_ctor_get_usize("; emit x; emit ", "; emit i; emitLn ");"
@@ -443,12 +499,14 @@ def emitPartialApp (z : VarId) (f : FunId) (ys : Array Arg) : M Unit := do
     let y := ys[i]!
     emit "lean_closure_set("; emit z; emit ", "; emit i; emit ", "; emitArg y; emitLn ");"
 
-def emitApp (z : VarId) (f : VarId) (ys : Array Arg) : M Unit :=
+/-- If `borrowed` is `true`, the closure `f` is not consumed, and `ys.size ≤ closureMaxArgs`. -/
+def emitApp (z : VarId) (f : VarId) (ys : Array Arg) (borrowed := false) : M Unit :=
   if ys.size > closureMaxArgs then do
     emit "{ lean_object* _aargs[] = {"; emitArgs ys; emitLn "};";
     emitLhs z; emit "lean_apply_m("; emit f; emit ", "; emit ys.size; emitLn ", _aargs); }"
   else do
-    emitLhs z; emit "lean_apply_"; emit ys.size; emit "("; emit f; emit ", "; emitArgs ys; emitLn ");"
+    emitLhs z; emit (if borrowed then "lean_apply_borrowed_" else "lean_apply_")
+    emit ys.size; emit "("; emit f; emit ", "; emitArgs ys; emitLn ");"
 
 def emitBoxFn (xType : IRType) : M Unit :=
   match xType with
@@ -510,7 +568,7 @@ def emitLit (z : VarId) (t : IRType) (v : LitVal) : M Unit := do
 
 def emitVDecl (z : VarId) (t : IRType) (v : Expr) : M Unit :=
   match v with
-  | Expr.ctor c ys      => emitCtor z c ys
+  | Expr.ctor c ys      => if t.isStruct then emitStructCtor z ys else emitCtor z c ys
   | Expr.reset n x      => emitReset z n x
   | Expr.reuse x c u ys => emitReuse z x c u ys
   | Expr.proj i x       => emitProj z i x
@@ -582,6 +640,16 @@ def emitTailCall (v : Expr) : M Unit :=
     emitLn "goto _start;"
   | _ => throw "bug at emitTailCall"
 
+/--
+Return `true` if `b` is of the form `inc ys; let z := ap x zs`, where `x` is not among the `ys` and `zs`.
+In this case, `inc x; b` is emitted as an application of the borrowed closure `x`, which saves the
+`lean_inc`/`lean_dec_ref` of `x` when the application is saturating, e.g., in loops of higher-order
+functions applying their closure argument. -/
+partial def isBorrowedApp (x : VarId) : FnBody → Bool
+  | .inc y _ _ _ b          => y != x && isBorrowedApp x b
+  | .vdecl _ _ (.ap f ys) _ => f == x && !ys.contains (.var x) && ys.size ≤ closureMaxArgs
+  | _                       => false
+
 mutual
 
 partial def emitIf (x : VarId) (xType : IRType) (tag : Nat) (t : FnBody) (e : FnBody) : M Unit := do
@@ -613,10 +681,16 @@ partial def emitBlock (b : FnBody) : M Unit := do
       emitVDecl x t v
       emitBlock b
   | FnBody.inc x n c p b       =>
-    unless p do emitInc x n c
-    emitBlock b
+    if n == 1 && !p && isBorrowedApp x b then
+      emitBorrowedApp x b
+    else
+      unless p do emitInc x n c
+      emitBlock b
   | FnBody.dec x n c p b       =>
-    unless p do emitDec x n c
+    if let some info := (← read).stackCtors.find? x then
+      emitStackDec x info
+    else if !p then
+      emitDec x n c
     emitBlock b
   | FnBody.del x b             => emitDel x; emitBlock b
   | FnBody.setTag x i b        => emitSetTag x i; emitBlock b
@@ -629,6 +703,15 @@ partial def emitBlock (b : FnBody) : M Unit := do
   | FnBody.jmp j xs            => emitJmp j xs
   | FnBody.unreachable         => emitLn "lean_internal_panic_unreachable();"
 
+partial def emitBorrowedApp (x : VarId) : FnBody → M Unit
+  | FnBody.inc y n c p b             => do
+    unless p do emitInc y n c
+    emitBorrowedApp x b
+  | FnBody.vdecl z _ (.ap _ ys) b    => do
+    emitApp z x ys (borrowed := true)
+    emitBlock b
+  | b                                => emitBlock b
+
 partial def emitJPs : FnBody → M Unit
   | FnBody.jdecl j _  v b => do emit j; emitLn ":"; emitFnBody v; emitJPs b
   | e                     => do unless e.isTerminal do emitJPs e.body
@@ -645,13 +728,14 @@ end
 
 def emitDeclAux (d : Decl) : M Unit := do
   let env ← getEnv
-  let (_, jpMap) := mkVarJPMaps d
-  withReader (fun ctx => { ctx with jpMap := jpMap }) do
+  let (varTypes, jpMap) := mkVarJPMaps d
+  let stackCtors := if (← read).stackAlloc then EscapeAnalysis.collectStackCtors d else {}
+  withReader (fun ctx => { ctx with jpMap, varTypes, stackCtors }) do
   unless hasInitAttr env d.name do
     match d with
     | .fdecl (f := f) (xs := xs) (type := t) (body := b) .. =>
       let baseName ← toCName f;
-      if xs.size == 0 then
+      if xs.size == 0 || (← isCopiedDecl f) || isUnboxedName f then
         emit "static "
       else if shouldExport f then
         emit "LEAN_EXPORT "  -- make symbol visible to the interpreter
@@ -687,9 +771,9 @@ def emitDecl (d : Decl) : M Unit := do
     throw s!"{err}\ncompiling:\n{d}"
 
 def emitFns : M Unit := do
-  let env ← getEnv;
-  let decls := getDecls env;
+  let decls := (← read).decls
   decls.reverse.forM emitDecl
+  (← read).copiedDecls.toList.forM fun n => do emitDecl (← getDecl n)
 
 def emitMarkPersistent (d : Decl) (n : Name) : M Unit := do
   if d.resultType.isObj then
@@ -746,8 +830,54 @@ def emitInitFn : M Unit := do
   decls.reverse.forM emitDeclInit
   emitLns ["return lean_io_result_mk_ok(lean_box(0));", "}"]
 
+/--
+Imported functions that may be copied into the current module: constants are excluded as they are
+initialized by their own module, as are functions with export names, which may be declared by
+`lean.h`, and functions using the closed terms of their module, which are `static` there. -/
+def isCopyableDecl (env : Environment) (d : Decl) : Bool :=
+  match d with
+  | .fdecl (xs := xs) .. =>
+    !xs.isEmpty && (getExportNameFor? env d.name).isNone && !hasInitAttr env d.name &&
+      !(collectUsedDecls env d).toList.any isExtractClosedAuxFn
+  | .extern .. => false
+
+/--
+Collect the copyable imported functions reachable from the given names without going through a
+function that is not copyable. -/
+partial def collectCopiedDecls (env : Environment) (modDecls : NameSet) : List Name → NameSet → NameSet
+  | [],      copied => copied
+  | n :: ns, copied =>
+    if modDecls.contains n || copied.contains n then
+      collectCopiedDecls env modDecls ns copied
+    else match findEnvDecl env n with
+      | some d =>
+        if isCopyableDecl env d then
+          collectCopiedDecls env modDecls ((collectUsedDecls env d).toList ++ ns) (copied.insert n)
+        else
+          collectCopiedDecls env modDecls ns copied
+      | none => collectCopiedDecls env modDecls ns copied
+
+/-- The imported functions to emit as `static` copies if `compiler.wholeProgram` is set. -/
+def getCopiedDecls (env : Environment) (opts : Options) : NameSet :=
+  let decls := getDecls env
+  let modDecls : NameSet := decls.foldl (fun s d => s.insert d.name) {}
+  if compiler.wholeProgram.get opts && modDecls.contains `main then
+    let used := decls.foldl (fun s d => collectUsedDecls env d s) {}
+    collectCopiedDecls env modDecls used.toList {}
+  else {}
+
+/-- Declare the C types of the `struct` values returned by the functions of the module. -/
+def emitStructTypes : M Unit := do
+  let sizes := (← read).decls.foldl (init := #[]) fun sizes d =>
+    match d.resultType with
+    | .struct _ tys => if sizes.contains tys.size then sizes else sizes.push tys.size
+    | _             => sizes
+  sizes.forM fun n =>
+    emitLn s!"typedef struct \{ lean_object* f[{n}]; } lean_ir_struct{n};"
+
 def main : M Unit := do
   emitFileHeader
+  emitStructTypes
   emitFnDecls
   emitFns
   emitInitFn
@@ -757,8 +887,11 @@ def main : M Unit := do
 end EmitC
 
 @[export lean_ir_emit_c]
-def emitC (env : Environment) (modName : Name) : Except String String :=
-  match (EmitC.main { env := env, modName := modName }).run "" with
+def emitC (env : Environment) (modName : Name) (opts : Options) : Except String String :=
+  let decls   := UnboxResult.unboxResults env (getDecls env).toArray
+  let declMap : NameMap Decl := decls.foldl (fun m d => m.insert d.name d) {}
+  let stackAlloc := EmitC.compiler.stackAlloc.get opts
+  match (EmitC.main { env, modName, copiedDecls := EmitC.getCopiedDecls env opts, decls, declMap, stackAlloc }).run "" with
   | EStateM.Result.ok    _   s => Except.ok s
   | EStateM.Result.error err _ => Except.error err
 
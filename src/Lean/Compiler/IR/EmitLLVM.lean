@@ -1575,6 +1575,27 @@ def main : M llvmctx Unit := do
   emitFns (← getLLVMModule) builder
   emitInitFn (← getLLVMModule) builder
   emitMainFnIfNeeded (← getLLVMModule) builder
+
+/--
+Emits the declarations `decls` for the interpreter's JIT tier (see `ir_jit.cpp`). Other declarations used by them are
+only declared and must be provided by the current process. The values of nullary declarations in `decls` are stored in
+globals defined by the module, which must be set by calling their initializers. Returns, for each declaration, the
+symbol name of its function or initializer and, if it is nullary, the symbol name of its global.
+-/
+def emitJIT (decls : Array Decl) : M llvmctx (Array (String × String)) := do
+  let env ← getEnv
+  let defined : NameSet := decls.foldl (fun s d => s.insert d.name) {}
+  let usedDecls : NameSet := decls.foldl (fun s d => collectUsedDecls env d (s.insert d.name)) {}
+  for n in usedDecls.toList do
+    let decl ← getDecl n
+    match getExternNameFor env `c decl.name with
+    | some cName => emitExternDeclAux decl cName
+    | none       => emitFnDecl decl (!defined.contains n)
+  let builder ← LLVM.createBuilderInContext llvmctx
+  decls.forM (emitDecl (← getLLVMModule) builder)
+  decls.mapM fun d => do
+    let cName ← toCName d.name
+    return if d.params.isEmpty then ("_init_" ++ cName, cName) else (cName, "")
 end EmitLLVM
 
 def getLeanHBcPath : IO System.FilePath := do
@@ -1594,6 +1615,37 @@ partial def getModuleFunctions (mod : LLVM.Module llvmctx) : IO (Array (LLVM.Val
     else go (← LLVM.getNextFunction v) (acc.push v)
   go (← LLVM.getFirstFunction mod) #[]
 
+/--
+Links the runtime bitcode `lean.h.bc` into `mod`, giving its definitions internal linkage, and verifies the result.
+-/
+def linkRuntime (llvmctx : LLVM.Context) (mod : LLVM.Module llvmctx) : IO Unit := do
+  let membuf ← LLVM.createMemoryBufferWithContentsOfFile (← getLeanHBcPath).toString
+  let modruntime ← LLVM.parseBitcode llvmctx membuf
+  /- It is important that we extract the names here because
+     pointers into modruntime get invalidated by linkModules -/
+  let runtimeGlobals ← (← getModuleGlobals modruntime).mapM (·.getName)
+  let filter func := do
+    -- | Do not insert internal linkage for
+    -- intrinsics such as `@llvm.umul.with.overflow.i64` which clang generates, and also
+    -- for declarations such as `lean_inc_ref_cold` which are externally defined.
+    if (← LLVM.isDeclaration func) then
+      return none
+    else
+      return some (← func.getName)
+  let runtimeFunctions ← (← getModuleFunctions modruntime).filterMapM filter
+  LLVM.linkModules (dest := mod) (src := modruntime)
+  -- Mark every global and function as having internal linkage.
+  for name in runtimeGlobals do
+    let some global ← LLVM.getNamedGlobal mod name
+       | throw <| IO.Error.userError s!"ERROR: linked module must have global from runtime module: '{name}'"
+    LLVM.setLinkage global LLVM.Linkage.internal
+  for name in runtimeFunctions do
+    let some fn ← LLVM.getNamedFunction mod name
+       | throw <| IO.Error.userError s!"ERROR: linked module must have function from runtime module: '{name}'"
+    LLVM.setLinkage fn LLVM.Linkage.internal
+  if let some err ← LLVM.verifyModule mod then
+    throw <| .userError err
+
 /--
 `emitLLVM` is the entrypoint for the lean shell to code generate LLVM.
 -/
@@ -1607,33 +1659,30 @@ def emitLLVM (env : Environment) (modName : Name) (filepath : String) : IO Unit
   let out? ← ((EmitLLVM.main (llvmctx := llvmctx)).run initState).run emitLLVMCtx
   match out? with
   | .ok _ => do
-         let membuf ← LLVM.createMemoryBufferWithContentsOfFile (← getLeanHBcPath).toString
-         let modruntime ← LLVM.parseBitcode llvmctx membuf
-         /- It is important that we extract the names here because
-            pointers into modruntime get invalidated by linkModules -/
-         let runtimeGlobals ← (← getModuleGlobals modruntime).mapM (·.getName)
-         let filter func := do
-           -- | Do not insert internal linkage for
-           -- intrinsics such as `@llvm.umul.with.overflow.i64` which clang generates, and also
-           -- for declarations such as `lean_inc_ref_cold` which are externally defined.
-           if (← LLVM.isDeclaration func) then
-             return none
-           else
-             return some (← func.getName)
-         let runtimeFunctions ← (← getModuleFunctions modruntime).filterMapM filter
-         LLVM.linkModules (dest := emitLLVMCtx.llvmmodule) (src := modruntime)
-         -- Mark every global and function as having internal linkage.
-         for name in runtimeGlobals do
-           let some global ← LLVM.getNamedGlobal emitLLVMCtx.llvmmodule name
-              | throw <| IO.Error.userError s!"ERROR: linked module must have global from runtime module: '{name}'"
-           LLVM.setLinkage global LLVM.Linkage.internal
-         for name in runtimeFunctions do
-           let some fn ← LLVM.getNamedFunction emitLLVMCtx.llvmmodule name
-              | throw <| IO.Error.userError s!"ERROR: linked module must have function from runtime module: '{name}'"
-           LLVM.setLinkage fn LLVM.Linkage.internal
-         if let some err ← LLVM.verifyModule emitLLVMCtx.llvmmodule then
-           throw <| .userError err
+         linkRuntime llvmctx emitLLVMCtx.llvmmodule
          LLVM.writeBitcodeToFile emitLLVMCtx.llvmmodule filepath
          LLVM.disposeModule emitLLVMCtx.llvmmodule
   | .error err => throw (IO.Error.userError err)
+
+/--
+Entrypoint of the interpreter's JIT tier (see `ir_jit.cpp`): emits `decls` into a new module of `llvmctx` as described
+at `EmitLLVM.emitJIT` and links it with the runtime bitcode. Returns the module and the symbol names of `decls`.
+-/
+@[export lean_ir_emit_llvm_jit]
+def emitLLVMJIT (env : Environment) (llvmctx : LLVM.Context) (decls : Array Name) :
+    IO (LLVM.Module llvmctx × Array (String × String)) := do
+  let decls ← decls.mapM fun n => match findEnvDecl env n with
+    | some d => pure d
+    | none   => throw <| IO.userError s!"unknown declaration '{n}'"
+  let module ← LLVM.createModule llvmctx "jit"
+  let emitLLVMCtx : EmitLLVM.Context llvmctx := {env := env, modName := `jit, llvmmodule := module}
+  let initState := { var2val := default, jp2bb := default : EmitLLVM.State llvmctx}
+  let out? ← ((EmitLLVM.emitJIT (llvmctx := llvmctx) decls).run initState).run emitLLVMCtx
+  match out? with
+  | .ok (names, _) =>
+    linkRuntime llvmctx module
+    return (module, names)
+  | .error err =>
+    LLVM.disposeModule module
+    throw (IO.Error.userError err)
 end Lean.IR
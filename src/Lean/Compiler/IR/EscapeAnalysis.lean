@@ -0,0 +1,53 @@
+/-
+Copyright (c) 2024 Lean FRO, LLC. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+-/
+prelude
+import Lean.Compiler.IR.CompilerM
+import Lean.Compiler.IR.FreeVars
+
+/-!
+Escape analysis for constructor objects. The object built by `x := ctor c ys` does not escape its
+function if the rest of the function only reads its fields and tag, and releases it with a single
+`dec x` on every path. Such an object is never shared, so `EmitC` can allocate it on the C stack
+and replace `dec x` with the `dec`s of its fields.
+
+The analysis runs on the IR after explicit RC and boxing, and does not change the IR.
+-/
+
+namespace Lean.IR.EscapeAnalysis
+
+/-- Maximal number of object and `usize` fields of the objects allocated on the stack. -/
+def maxStackCtorFields := 16
+
+/-- Return `true` if on every path of `b`, `x` is only read and then released by a single `dec`. -/
+partial def isLocal (x : VarId) : FnBody → Bool
+  | .vdecl _ _ (.proj ..) b
+  | .vdecl _ _ (.uproj ..) b
+  | .vdecl _ _ (.sproj ..) b
+  | .uset _ _ _ b
+  | .sset _ _ _ _ _ b      => isLocal x b
+  | .dec y n _ _ b         => if y == x then n == 1 && !b.hasFreeVar x else isLocal x b
+  | .jdecl _ _ v b         => !v.hasFreeVar x && isLocal x b
+  | .case _ _ _ alts       => alts.all (isLocal x ·.body)
+  | .unreachable           => true
+  | b                      => !b.isTerminal && !b.resetBody.hasFreeVar x && isLocal x b.body
+
+def isStackCtor (c : CtorInfo) : Bool :=
+  !c.isScalar && c.size + c.usize ≤ maxStackCtorFields && c.ssize ≤ 8 * maxStackCtorFields
+
+partial def collectFnBody : FnBody → HashMap VarId CtorInfo → HashMap VarId CtorInfo
+  | .vdecl x t (.ctor c _) b, m =>
+    let m := if t.isObj && isStackCtor c && isLocal x b then m.insert x c else m
+    collectFnBody b m
+  | .jdecl _ _ v b, m    => collectFnBody b (collectFnBody v m)
+  | .case _ _ _ alts, m  => alts.foldl (fun m alt => collectFnBody alt.body m) m
+  | b, m                 => if b.isTerminal then m else collectFnBody b.body m
+
+/-- Return the variables of `d` bound to constructor objects that do not escape `d`. -/
+def collectStackCtors (d : Decl) : HashMap VarId CtorInfo :=
+  match d with
+  | .fdecl (body := b) .. => collectFnBody b {}
+  | .extern .. => {}
+
+end Lean.IR.EscapeAnalysis
@@ -6,6 +6,7 @@ Authors: Leonardo de Moura
 prelude
 import Lean.Data.Format
 import Lean.Compiler.IR.Basic
+import Lean.Compiler.IR.FreeVars
 
 namespace Lean.IR.UnboxResult
 
@@ -21,4 +22,181 @@ builtin_initialize unboxAttr : TagAttribute ←
 def hasUnboxAttr (env : Environment) (n : Name) : Bool :=
 unboxAttr.hasTag env n
 
+/-!
+Functions of the current module that return a fresh object of a small structure (e.g., `Prod`) on
+every path are split into a worker, which returns the fields as a `struct` value instead, and a
+wrapper with the original name and signature, which allocates the object from the worker's result.
+Calls whose result is only projected and then released use the worker instead, and workers return
+the result of other workers directly, so that these values are passed between the functions of
+the module without being allocated.
+
+The transformation is applied by `EmitC` to the final IR of the module. The declarations stored
+in the environment, which are used by the interpreter and by other modules, are not affected.
+-/
+
+/-- Maximal number of fields of structures returned as `struct` values. -/
+def maxStructFields := 4
+
+def mkUnboxedName (n : Name) : Name :=
+  Name.mkStr n "_unboxed"
+
+def isUnboxedName (n : Name) : Bool :=
+  n matches .str _ "_unboxed"
+
+/-- The `struct` type holding the fields of an object built with `c`. -/
+def mkStructType (c : CtorInfo) : IRType :=
+  .struct (some c.name.getPrefix) (mkArray c.size IRType.tobject)
+
+/--
+Return `true` if `c` is the only constructor of a non-recursive type and has between 2 and
+`maxStructFields` fields, all of them objects. -/
+def isUnboxableCtor (env : Environment) (c : CtorInfo) : Bool :=
+  c.usize == 0 && c.ssize == 0 && 2 ≤ c.size && c.size ≤ maxStructFields &&
+  match env.find? c.name with
+  | some (.ctorInfo v) =>
+    match env.find? v.induct with
+    | some (.inductInfo I) => I.ctors.length == 1 && !I.isRec
+    | _ => false
+  | _ => false
+
+/-- Return `true` if `b` is a sequence of `inc`/`dec` instructions on other variables followed by `ret x`. -/
+partial def isRetOf (x : VarId) : FnBody → Bool
+  | .inc y _ _ _ b => y != x && isRetOf x b
+  | .dec y _ _ _ b => y != x && isRetOf x b
+  | .ret (.var y)  => y == x
+  | _              => false
+
+/--
+Collect the constructors of the objects returned by `b`, or return `none` if some `ret` does not
+return a fresh object or the result of a call. -/
+partial def collectRetCtors : FnBody → Array CtorInfo → Option (Array CtorInfo)
+  | .vdecl x _ e b, cs =>
+    if isRetOf x b then
+      match e with
+      | .ctor c _ => some (cs.push c)
+      | .fap .. | .ap .. => some cs
+      | _ => none
+    else
+      collectRetCtors b cs
+  | .jdecl _ _ v b, cs => do collectRetCtors b (← collectRetCtors v cs)
+  | .case _ _ _ alts, cs => alts.foldlM (fun cs alt => collectRetCtors alt.body cs) cs
+  | .ret _, _ => none
+  | .jmp .., cs => some cs
+  | .unreachable, cs => some cs
+  | b, cs => collectRetCtors b.body cs
+
+/-- If `d` is split into a worker and a wrapper, return the constructor of its results. -/
+def isCandidate? (env : Environment) (d : Decl) : Option CtorInfo := do
+  let .fdecl (xs := xs) (type := t) (body := b) .. := d | none
+  guard (!xs.isEmpty && t.isObj)
+  let cs ← collectRetCtors b #[]
+  let c ← cs[0]?
+  guard (isUnboxableCtor env c && cs.all (·.name == c.name))
+  return c
+
+/-- Return `true` if on every path of `b`, `x` is only projected and then released by a single `dec`. -/
+partial def isProjectedAndReleased (x : VarId) (n : Nat) : FnBody → Bool
+  | .vdecl _ _ (.proj i y) b => (y != x || i < n) && isProjectedAndReleased x n b
+  | .dec y k _ _ b           => if y == x then k == 1 && !b.hasFreeVar x else isProjectedAndReleased x n b
+  | .jdecl _ _ v b           => !v.hasFreeVar x && isProjectedAndReleased x n b
+  | .case _ y _ alts         => y != x && alts.all (isProjectedAndReleased x n ·.body)
+  | .unreachable             => true
+  | b                        => !b.isTerminal && !b.resetBody.hasFreeVar x && isProjectedAndReleased x n b.body
+
+structure Context where
+  candidates : NameMap CtorInfo
+  /-- The `struct` type and constructor of the results when creating a worker. -/
+  worker?    : Option (IRType × CtorInfo) := none
+
+abbrev M := ReaderT Context (StateM Index)
+
+def mkFresh : M VarId :=
+  modifyGet fun n => ({ idx := n }, n + 1)
+
+/-- Replace the `ret x` ending `b`, see `isRetOf`, with `k`. -/
+partial def replaceRet (x : VarId) (k : FnBody) : FnBody → FnBody
+  | .inc y n c p b => .inc y n c p (replaceRet x k b)
+  | .dec y n c p b => .dec y n c p (replaceRet x k b)
+  | _              => k
+
+/-- Replace `dec x`, where `x` is now a `struct` value with `n` fields, with `dec`s of its fields. -/
+partial def decFields (x : VarId) (n : Nat) : FnBody → M FnBody
+  | .dec y k c p b =>
+    if y == x then do
+      let mut b := b
+      for i in [0:n] do
+        let z ← mkFresh
+        b := .vdecl z .tobject (.proj i x) (.dec z 1 true false b)
+      return b
+    else
+      .dec y k c p <$> decFields x n b
+  | .jdecl j ys v b    => .jdecl j ys v <$> decFields x n b
+  | .case tid y t alts => .case tid y t <$> alts.mapM (·.mmodifyBody (decFields x n))
+  | b                  => if b.isTerminal then pure b else b.setBody <$> decFields x n b.body
+
+/-- Return the `struct` value `x := e` of a worker instead of an object, where `b` ends with `ret x`. -/
+def mkWorkerRet (x : VarId) (t : IRType) (e : Expr) (b : FnBody) (ty : IRType) (c : CtorInfo) : M FnBody := do
+  match e with
+  | .ctor c' ys => return .vdecl x ty (.ctor c' ys) b
+  | .fap f ys  =>
+    if (← read).candidates.contains f then
+      return .vdecl x ty (.fap (mkUnboxedName f) ys) b
+  | _ => pure ()
+  -- unpack the object returned by `e`
+  let ys ← (Array.range c.size).mapM fun _ => mkFresh
+  let s ← mkFresh
+  let mut k := FnBody.dec x 1 true false (.vdecl s ty (.ctor c (ys.map Arg.var)) (.ret (.var s)))
+  for i in [0:ys.size] do
+    k := .vdecl ys[i]! .tobject (.proj i x) (.inc ys[i]! 1 true false k)
+  return .vdecl x t e (replaceRet x k b)
+
+partial def visitFnBody : FnBody → M FnBody
+  | .vdecl x t e b => do
+    let ctx ← read
+    if let some (ty, c) := ctx.worker? then
+      if isRetOf x b then
+        return (← mkWorkerRet x t e b ty c)
+    if let .fap f ys := e then
+      if let some c := ctx.candidates.find? f then
+        if isProjectedAndReleased x c.size b then
+          return .vdecl x (mkStructType c) (.fap (mkUnboxedName f) ys) (← decFields x c.size (← visitFnBody b))
+    return .vdecl x t e (← visitFnBody b)
+  | .jdecl j xs v b        => return .jdecl j xs (← visitFnBody v) (← visitFnBody b)
+  | .case tid x xType alts => return .case tid x xType (← alts.mapM (·.mmodifyBody visitFnBody))
+  | b                      => if b.isTerminal then pure b else b.setBody <$> visitFnBody b.body
+
+/-- The body of the wrapper of worker `f`, which allocates the object from the worker's result. -/
+def mkWrapperBody (f : FunId) (xs : Array Param) (t : IRType) (ty : IRType) (c : CtorInfo) (fresh : Index) : FnBody := Id.run do
+  let r : VarId := { idx := fresh }
+  let o : VarId := { idx := fresh + 1 }
+  let ys := (Array.range c.size).map fun i => ({ idx := fresh + 2 + i } : VarId)
+  let mut b := FnBody.vdecl o t (.ctor c (ys.map Arg.var)) (.ret (.var o))
+  for i in [0:ys.size] do
+    b := .vdecl ys[i]! .tobject (.proj i r) b
+  return .vdecl r ty (.fap (mkUnboxedName f) (xs.map (Arg.var ·.x))) b
+
+/-- Split the candidates among `decls` into workers and wrappers, and make the other calls use the workers. -/
+def unboxResults (env : Environment) (decls : Array Decl) : Array Decl := Id.run do
+  let candidates : NameMap CtorInfo := decls.foldl (init := {}) fun m d =>
+    match isCandidate? env d with
+    | some c => m.insert d.name c
+    | none   => m
+  if candidates.isEmpty then
+    return decls
+  let mut r := #[]
+  for d in decls do
+    match d with
+    | .fdecl f xs t b info =>
+      let fresh := d.maxIndex + 1
+      match candidates.find? f with
+      | some c =>
+        let ty := mkStructType c
+        let b' := visitFnBody b |>.run { candidates, worker? := some (ty, c) } |>.run' fresh
+        r := r.push (.fdecl (mkUnboxedName f) xs ty b' info)
+        r := r.push (.fdecl f xs t (mkWrapperBody f xs t ty c fresh) info)
+      | none =>
+        r := r.push (.fdecl f xs t (visitFnBody b |>.run { candidates } |>.run' fresh) info)
+    | .extern .. => r := r.push d
+  return r
+
 end Lean.IR.UnboxResult
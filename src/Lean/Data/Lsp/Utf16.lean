@@ -55,9 +55,8 @@ def utf16PosToCodepointPos (s : String) (pos : Nat) : Nat :=
   utf16PosToCodepointPosFrom s pos 0
 
 /-- Starting at `utf8pos`, finds the UTF-8 offset of the `p`-th codepoint. -/
-def codepointPosToUtf8PosFrom (s : String) : String.Pos → Nat → String.Pos
-  | utf8pos, 0 => utf8pos
-  | utf8pos, p+1 => codepointPosToUtf8PosFrom s (s.next utf8pos) p
+def codepointPosToUtf8PosFrom (s : String) (utf8pos : String.Pos) (p : Nat) : String.Pos :=
+  s.nextn utf8pos p
 
 end String
 
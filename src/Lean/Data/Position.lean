@@ -72,12 +72,9 @@ partial def toPosition (fmap : FileMap) (pos : String.Pos) : Position :=
   match fmap with
   | { source := str, positions := ps } =>
     if ps.size >= 2 && pos <= ps.back then
-      let rec toColumn (i : String.Pos) (c : Nat) : Nat :=
-        if i == pos || str.atEnd i then c
-        else toColumn (str.next i) (c+1)
       let rec loop (b e : Nat) :=
         let posB := ps[b]!
-        if e == b + 1 then { line := fmap.getLine b, column := toColumn posB 0 }
+        if e == b + 1 then { line := fmap.getLine b, column := str.countChars posB pos }
         else
           let m := (b + e) / 2;
           let posM := ps.get! m;
@@ -102,7 +99,7 @@ def ofPosition (text : FileMap) (pos : Position) : String.Pos :=
       0
     else
       text.positions.back
-  String.Iterator.nextn ⟨text.source, colPos⟩ pos.column |>.pos
+  text.source.nextn colPos pos.column
 
 /--
 Returns the position of the start of (1-based) line `line`.
@@ -678,6 +678,15 @@ opaque saveModuleData (fname : @& System.FilePath) (mod : @& Name) (data : @& Mo
 @[extern "lean_read_module_data"]
 opaque readModuleData (fname : @& System.FilePath) : IO (ModuleData × CompactedRegion)
 
+/--
+  Saves `objs` in `.olean` format so that the file can be used as a shared object dictionary: when the environment
+  variable `LEAN_OLEAN_DICTIONARY` points to it, `.olean` files reference objects of the dictionary (e.g. common
+  `Name`s, `Level`s, and `Expr`s) instead of storing their own copies of them. Reading such `.olean` files requires the
+  variable to point to the same dictionary. See `script/mkOleanDictionary.lean` for building a dictionary from existing
+  `.olean` files. -/
+@[extern "lean_save_olean_dictionary"]
+opaque saveOleanDictionary (fname : @& System.FilePath) (objs : @& Array NonScalar) : IO Unit
+
 /--
   Free compacted regions of imports. No live references to imported objects may exist at the time of invocation; in
   particular, `env` should be the last reference to any `Environment` derived from these imports. -/
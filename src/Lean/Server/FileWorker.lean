@@ -744,6 +744,7 @@ def workerMain (opts : Options) : IO UInt32 := do
     let exitCode ← initAndRunWorker i o e opts
     -- HACK: all `Task`s are currently "foreground", i.e. we join on them on main thread exit, but we definitely don't
     -- want to do that in the case of the worker processes, which can produce non-terminating tasks evaluating user code
+    try IR.saveInterpreterProfile catch err => e.putStrLn s!"{err}"
     o.flush
     e.flush
     IO.Process.exit exitCode.toUInt8
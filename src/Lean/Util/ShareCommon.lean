@@ -5,6 +5,7 @@ Authors: Leonardo de Moura
 -/
 prelude
 import Init.ShareCommon
+import Init.System.IO
 import Lean.Data.HashSet
 import Lean.Data.HashMap
 import Lean.Data.PersistentHashMap
@@ -48,3 +49,36 @@ instance PShareCommonT.monadShareCommon [Monad m] : MonadShareCommon (PShareComm
 @[inline] def PShareCommonM.run : PShareCommonM α → α := PShareCommonT.run
 
 def shareCommon (a : α) : α := (withShareCommon a : ShareCommonM α).run
+
+private opaque TableImpl : NonemptyType.{0}
+
+/--
+A concurrent hash-consing table.
+Objects shared using the same table are maximally shared with each other, even if they are
+produced by different tasks, and the table persists across `Table.shareCommon` invocations.
+The table owns references to its objects, `Table.prune` releases the ones that are not used anywhere else.
+-/
+def Table : Type := TableImpl.type
+
+instance : Nonempty Table := TableImpl.property
+
+/-- Creates a new empty `Table`. -/
+@[extern "lean_sharecommon_table_new"]
+opaque Table.new : BaseIO Table
+
+/--
+Returns an object equal to `a` where all subterms are maximally shared with respect to
+the objects already stored in `t`. Safe to use concurrently from multiple tasks.
+-/
+@[extern "lean_sharecommon_table_share"]
+def Table.shareCommon (t : @& Table) (a : α) : BaseIO α := pure a
+
+/--
+Removes the objects that are only referenced by `t`, and returns the number of removed objects.
+-/
+@[extern "lean_sharecommon_table_prune"]
+opaque Table.prune (t : @& Table) : BaseIO Nat
+
+/-- Returns the number of objects stored in `t`. -/
+@[extern "lean_sharecommon_table_size"]
+opaque Table.size (t : @& Table) : BaseIO Nat
@@ -670,6 +670,23 @@ LEAN_EXPORT lean_object* lean_apply_16(lean_object* f, lean_object* a1, lean_obj
 LEAN_EXPORT lean_object* lean_apply_n(lean_object* f, unsigned n, lean_object** args);
 /* Pre: n > 16 */
 LEAN_EXPORT lean_object* lean_apply_m(lean_object* f, unsigned n, lean_object** args);
+/* Like `lean_apply_<n>`, but `f` is borrowed. */
+LEAN_EXPORT lean_object* lean_apply_borrowed_1(b_lean_obj_arg f, lean_object* a1);
+LEAN_EXPORT lean_object* lean_apply_borrowed_2(b_lean_obj_arg f, lean_object* a1, lean_object* a2);
+LEAN_EXPORT lean_object* lean_apply_borrowed_3(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3);
+LEAN_EXPORT lean_object* lean_apply_borrowed_4(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4);
+LEAN_EXPORT lean_object* lean_apply_borrowed_5(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5);
+LEAN_EXPORT lean_object* lean_apply_borrowed_6(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6);
+LEAN_EXPORT lean_object* lean_apply_borrowed_7(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7);
+LEAN_EXPORT lean_object* lean_apply_borrowed_8(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8);
+LEAN_EXPORT lean_object* lean_apply_borrowed_9(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8, lean_object* a9);
+LEAN_EXPORT lean_object* lean_apply_borrowed_10(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8, lean_object* a9, lean_object* a10);
+LEAN_EXPORT lean_object* lean_apply_borrowed_11(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8, lean_object* a9, lean_object* a10, lean_object* a11);
+LEAN_EXPORT lean_object* lean_apply_borrowed_12(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8, lean_object* a9, lean_object* a10, lean_object* a11, lean_object* a12);
+LEAN_EXPORT lean_object* lean_apply_borrowed_13(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8, lean_object* a9, lean_object* a10, lean_object* a11, lean_object* a12, lean_object* a13);
+LEAN_EXPORT lean_object* lean_apply_borrowed_14(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8, lean_object* a9, lean_object* a10, lean_object* a11, lean_object* a12, lean_object* a13, lean_object* a14);
+LEAN_EXPORT lean_object* lean_apply_borrowed_15(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8, lean_object* a9, lean_object* a10, lean_object* a11, lean_object* a12, lean_object* a13, lean_object* a14, lean_object* a15);
+LEAN_EXPORT lean_object* lean_apply_borrowed_16(b_lean_obj_arg f, lean_object* a1, lean_object* a2, lean_object* a3, lean_object* a4, lean_object* a5, lean_object* a6, lean_object* a7, lean_object* a8, lean_object* a9, lean_object* a10, lean_object* a11, lean_object* a12, lean_object* a13, lean_object* a14, lean_object* a15, lean_object* a16);
 
 /* Arrays of objects (low level API) */
 static inline lean_obj_res lean_alloc_array(size_t size, size_t capacity) {
@@ -856,6 +873,10 @@ LEAN_EXPORT lean_obj_res lean_byte_array_mk(lean_obj_arg a);
 LEAN_EXPORT lean_obj_res lean_byte_array_data(lean_obj_arg a);
 LEAN_EXPORT lean_obj_res lean_copy_byte_array(lean_obj_arg a);
 LEAN_EXPORT uint64_t lean_byte_array_hash(b_lean_obj_arg a);
+LEAN_EXPORT uint8_t lean_byte_array_beq(b_lean_obj_arg a, b_lean_obj_arg b);
+LEAN_EXPORT lean_obj_res lean_byte_array_index_of(b_lean_obj_arg a, uint8_t b, b_lean_obj_arg start);
+LEAN_EXPORT lean_obj_res lean_byte_array_fill(lean_obj_arg a, uint8_t v, b_lean_obj_arg off, b_lean_obj_arg len);
+LEAN_EXPORT lean_obj_res lean_byte_array_xor(lean_obj_arg a, b_lean_obj_arg b);
 
 static inline lean_obj_res lean_mk_empty_byte_array(b_lean_obj_arg capacity) {
     if (!lean_is_scalar(capacity)) lean_internal_panic_out_of_memory();
@@ -915,6 +936,10 @@ static inline lean_obj_res lean_byte_array_fset(lean_obj_arg a, b_lean_obj_arg i
 LEAN_EXPORT lean_obj_res lean_float_array_mk(lean_obj_arg a);
 LEAN_EXPORT lean_obj_res lean_float_array_data(lean_obj_arg a);
 LEAN_EXPORT lean_obj_res lean_copy_float_array(lean_obj_arg a);
+LEAN_EXPORT lean_obj_res lean_float_array_add(lean_obj_arg a, b_lean_obj_arg b);
+LEAN_EXPORT lean_obj_res lean_float_array_mul(lean_obj_arg a, b_lean_obj_arg b);
+LEAN_EXPORT double lean_float_array_sum(b_lean_obj_arg a);
+LEAN_EXPORT double lean_float_array_dot(b_lean_obj_arg a, b_lean_obj_arg b);
 
 static inline lean_obj_res lean_mk_empty_float_array(b_lean_obj_arg capacity) {
     if (!lean_is_scalar(capacity)) lean_internal_panic_out_of_memory();
@@ -1004,6 +1029,9 @@ static inline size_t lean_string_size(b_lean_obj_arg o) { return lean_to_string(
 static inline size_t lean_string_len(b_lean_obj_arg o) { return lean_to_string(o)->m_length; }
 LEAN_EXPORT lean_obj_res lean_string_push(lean_obj_arg s, uint32_t c);
 LEAN_EXPORT lean_obj_res lean_string_append(lean_obj_arg s1, b_lean_obj_arg s2);
+LEAN_EXPORT lean_obj_res lean_string_pushn(lean_obj_arg s, uint32_t c, b_lean_obj_arg n);
+LEAN_EXPORT lean_obj_res lean_string_join(b_lean_obj_arg l);
+LEAN_EXPORT lean_obj_res lean_string_intercalate(lean_obj_arg sep, lean_obj_arg l);
 static inline lean_obj_res lean_string_length(b_lean_obj_arg s) { return lean_box(lean_string_len(s)); }
 LEAN_EXPORT lean_obj_res lean_string_mk(lean_obj_arg cs);
 LEAN_EXPORT lean_obj_res lean_string_data(lean_obj_arg s);
@@ -1032,6 +1060,8 @@ static inline lean_obj_res lean_string_utf8_next_fast(b_lean_obj_arg s, b_lean_o
   return lean_string_utf8_next_fast_cold(idx, c);
 }
 
+LEAN_EXPORT lean_obj_res lean_string_utf8_next_n(b_lean_obj_arg s, b_lean_obj_arg i, b_lean_obj_arg n);
+LEAN_EXPORT lean_obj_res lean_string_utf8_count(b_lean_obj_arg s, b_lean_obj_arg b, b_lean_obj_arg e);
 LEAN_EXPORT lean_obj_res lean_string_utf8_prev(b_lean_obj_arg s, b_lean_obj_arg i);
 LEAN_EXPORT lean_obj_res lean_string_utf8_set(lean_obj_arg s, b_lean_obj_arg i, uint32_t c);
 static inline uint8_t lean_string_utf8_at_end(b_lean_obj_arg s, b_lean_obj_arg i) {
@@ -1049,6 +1079,7 @@ static inline uint8_t lean_string_dec_eq(b_lean_obj_arg s1, b_lean_obj_arg s2) {
 static inline uint8_t lean_string_dec_lt(b_lean_obj_arg s1, b_lean_obj_arg s2) { return lean_string_lt(s1, s2); }
 LEAN_EXPORT uint64_t lean_string_hash(b_lean_obj_arg);
 LEAN_EXPORT lean_obj_res lean_string_of_usize(size_t);
+LEAN_EXPORT lean_obj_res lean_string_to_nat(b_lean_obj_arg s);
 
 /* Thunks */
 
@@ -1167,6 +1198,8 @@ LEAN_EXPORT lean_object * lean_nat_big_lor(lean_object * a1, lean_object * a2);
 LEAN_EXPORT lean_object * lean_nat_big_xor(lean_object * a1, lean_object * a2);
 
 LEAN_EXPORT lean_obj_res lean_cstr_to_nat(char const * n);
+LEAN_EXPORT lean_obj_res lean_nat_to_decimal_string(b_lean_obj_arg n);
+LEAN_EXPORT lean_obj_res lean_nat_to_hex_string(b_lean_obj_arg n);
 LEAN_EXPORT lean_obj_res lean_big_usize_to_nat(size_t n);
 LEAN_EXPORT lean_obj_res lean_big_uint64_to_nat(uint64_t n);
 static inline lean_obj_res lean_usize_to_nat(size_t n) {
@@ -10,23 +10,42 @@ Motivation
 ==========
 
 Even with a JIT compiler, we still have a need for a simpler interpreter on platforms LLVM JIT does not support (i.e.
-WebAssembly). Because this is mostly an edge case, we strive for simplicity instead of performance and thus reuse the
-existing compiler IR instead of inventing something like a new bytecode format.
+WebAssembly). However, the interpreter is also used for all code of the current module as well as for imported code
+without native symbols, i.e. most metaprograms during development, so it should not be needlessly slow. We do not invent
+a new bytecode format stored in .olean files but decode the existing compiler IR into a flat, pre-resolved form on first
+use of each function.
 
 Implementation
 ==============
 
 The interpreter mainly consists of a homogeneous stack of `value`s, which are either unboxed values or pointers to boxed
 objects. The IR type system tells us which union member is active at any time. IR variables are mapped to stack
-slots by adding the current base pointer to the variable index. Further stacks are used for storing join points and call
-stack metadata. The interpreted IR is taken directly from the environment. Whenever possible, we try to switch to native
+slots by adding the current base pointer to the variable index; a stack frame reserves slots for all variables of a
+function upfront. A further stack is used for storing call stack metadata. The interpreted IR is taken directly from the
+environment and decoded into a `code` object the first time a function is executed: instructions are stored in a vector
+in execution order, join point bodies and case alternatives are referenced by instruction index, and constructor layouts
+and unboxed literals are computed ahead of time. Whenever possible, we try to switch to native
 code by checking for the mangled symbol via dlsym/GetProcAddress, which is also how we can call external functions
 (which only works if the file declaring them has already been compiled). We always call the "boxed" versions of native
 functions, which have a (relatively) homogeneous ABI that we can use without runtime code generation; see also
 `call/lookup_symbol` below.
 
+When LLVM support is available and `interpreter.jit_threshold` is set, imported functions without native code that
+are called often enough are compiled to native code in-process by `ir_jit.cpp`, together with the constants and
+functions they use that also lack native code; see `check_jit` below.
+
+If `interpreter.profile` is set, time and allocations are attributed to the call paths of interpreted functions and of
+native functions called by them; see `call_profile` below.
+
 */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 #ifdef LEAN_WINDOWS
 #include <windows.h>
@@ -35,22 +54,31 @@ functions, which have a (relatively) homogeneous ABI that we can use without run
 #include <dlfcn.h>
 #endif
 #include "runtime/flet.h"
+#include "runtime/alloc.h"
 #include "runtime/apply.h"
 #include "runtime/interrupt.h"
 #include "runtime/io.h"
 #include "runtime/option_ref.h"
 #include "runtime/array_ref.h"
+#include "runtime/thread.h"
 #include "kernel/trace.h"
 #include "library/time_task.h"
 #include "library/compiler/ir.h"
 #include "library/compiler/init_attribute.h"
+#include "library/compiler/ir_jit.h"
 #include "util/nat.h"
+#include "util/name_hash_map.h"
+#include "util/name_set.h"
 #include "util/option_declarations.h"
 
 #ifndef LEAN_DEFAULT_INTERPRETER_PREFER_NATIVE
 #define LEAN_DEFAULT_INTERPRETER_PREFER_NATIVE true
 #endif
 
+#ifndef LEAN_DEFAULT_INTERPRETER_JIT_THRESHOLD
+#define LEAN_DEFAULT_INTERPRETER_JIT_THRESHOLD 0
+#endif
+
 namespace lean {
 namespace ir {
 // C++ wrappers of Lean data types
@@ -185,12 +213,21 @@ option_ref<decl> find_ir_decl(environment const & env, name const & n) {
     return option_ref<decl>(lean_ir_find_env_decl(env.to_obj_arg(), n.to_obj_arg()));
 }
 
+extern "C" object * lean_ir_find_imported_env_decl(object * env, object * n);
+option_ref<decl> find_imported_ir_decl(environment const & env, name const & n) {
+    return option_ref<decl>(lean_ir_find_imported_env_decl(env.to_obj_arg(), n.to_obj_arg()));
+}
+
 extern "C" double lean_float_of_nat(lean_obj_arg a);
 
 static string_ref * g_mangle_prefix = nullptr;
 static string_ref * g_boxed_suffix = nullptr;
 static string_ref * g_boxed_mangled_suffix = nullptr;
 static name * g_interpreter_prefer_native = nullptr;
+static name * g_interpreter_jit_threshold = nullptr;
+static name * g_interpreter_profile = nullptr;
+// maximum number of declarations compiled together by `interpreter::jit`
+static constexpr size_t g_jit_max_decls = 256;
 
 // constants (lacking native declarations) initialized by `lean_run_init`
 static name_map<object *> * g_init_globals;
@@ -322,54 +359,380 @@ void * lookup_symbol_in_cur_exe(char const * sym) {
 class interpreter;
 LEAN_THREAD_PTR(interpreter, g_interpreter);
 
+// Slot of an irrelevant argument in `instr` operands, and target of unmatched `Case` tags
+static constexpr uint32 g_irrelevant_slot = std::numeric_limits<uint32>::max();
+static constexpr uint32 g_no_target = std::numeric_limits<uint32>::max();
+
+struct constant_cache_entry {
+    bool m_is_scalar;
+    value m_val;
+};
+
+/** \brief Return true if the constant value `o` may be stored in an `interpreter_cache`. Closures, thunks, tasks and
+    other mutable or opaque objects are rejected as they may reference the environment (see `mk_stub_closure`), which
+    would create a reference cycle through the cache. */
+static bool is_cacheable_constant(object * o) {
+    std::vector<object *> todo;
+    std::unordered_set<object *> visited;
+    todo.push_back(o);
+    while (!todo.empty()) {
+        o = todo.back();
+        todo.pop_back();
+        // persistent objects are not reference counted and thus cannot be part of a cycle
+        if (is_scalar(o) || lean_is_persistent(o) || !visited.insert(o).second)
+            continue;
+        switch (lean_ptr_tag(o)) {
+        case LeanArray:
+            for (size_t i = 0; i < array_size(o); i++)
+                todo.push_back(array_get(o, i));
+            break;
+        case LeanScalarArray: case LeanString: case LeanMPZ:
+            break;
+        case LeanClosure: case LeanThunk: case LeanTask: case LeanRef: case LeanExternal: case LeanReserved:
+            return false;
+        default:
+            for (unsigned i = 0; i < lean_ctor_num_objs(o); i++)
+                todo.push_back(cnstr_get(o, i));
+            break;
+        }
+    }
+    return true;
+}
+
+/** \brief Thread-safe cache of symbol lookups and constant values for imported declarations, shared by all
+    environments created by the same `importModules` call; see `Lean.IR.InterpreterCache`. Declarations of the current
+    module are never stored here since they may differ between environments sharing the cache. */
+class interpreter_cache {
+public:
+    struct symbol_info {
+        decl m_decl;
+        // see `interpreter::symbol_cache_entry`
+        void * m_addr;
+        bool m_boxed;
+        // whether the native code must be used even if `interpreter.prefer_native` is false
+        bool m_force_native;
+    };
+    struct symbol_entry {
+        symbol_info m_info;
+        // JIT tier state, see `interpreter::check_jit`
+        std::atomic<unsigned> m_calls{0};
+        std::atomic<bool> m_jit_started{false};
+        // compiled code, set at most once; `m_jit_boxed` is written before
+        std::atomic<void *> m_jit_addr{nullptr};
+        bool m_jit_boxed = false;
+
+        explicit symbol_entry(symbol_info const & info) : m_info(info) {}
+    };
+private:
+    mutex m_mutex;
+    name_hash_map<symbol_entry> m_symbols;
+    // non-scalar values are owned by the cache and marked as multi-threaded
+    name_hash_map<constant_cache_entry> m_constants;
+public:
+    ~interpreter_cache() {
+        for (auto const & p : m_constants) {
+            if (!p.second.m_is_scalar) {
+                dec(p.second.m_val.m_obj);
+            }
+        }
+    }
+
+    /** \brief Return entry of `fn` if any; entries are never removed. */
+    symbol_entry * find_symbol(name const & fn) {
+        lock_guard<mutex> _(m_mutex);
+        auto it = m_symbols.find(fn);
+        return it != m_symbols.end() ? &it->second : nullptr;
+    }
+
+    /** \brief Insert entry for `fn` unless another thread was faster, and return the entry. */
+    symbol_entry * insert_symbol(name const & fn, symbol_info const & info) {
+        lock_guard<mutex> _(m_mutex);
+        return &m_symbols.emplace(fn, info).first->second;
+    }
+
+    /** \brief Return cached value of constant `fn`, which the caller then owns. */
+    optional<constant_cache_entry> find_constant(name const & fn) {
+        lock_guard<mutex> _(m_mutex);
+        auto it = m_constants.find(fn);
+        if (it == m_constants.end()) {
+            return optional<constant_cache_entry>();
+        }
+        if (!it->second.m_is_scalar) {
+            inc(it->second.m_val.m_obj);
+        }
+        return optional<constant_cache_entry>(it->second);
+    }
+
+    /** \brief Store (borrowed) value of constant `fn` if possible. */
+    void insert_constant(name const & fn, constant_cache_entry const & e) {
+        if (!e.m_is_scalar) {
+            if (!is_cacheable_constant(e.m_val.m_obj)) {
+                return;
+            }
+            mark_mt(e.m_val.m_obj);
+        }
+        lock_guard<mutex> _(m_mutex);
+        if (m_constants.emplace(fn, e).second && !e.m_is_scalar) {
+            inc(e.m_val.m_obj);
+        }
+    }
+};
+
+static lean_external_class * g_interpreter_cache_external_class = nullptr;
+static void interpreter_cache_finalizer(void * c) {
+    delete static_cast<interpreter_cache *>(c);
+}
+static void interpreter_cache_foreach(void *, b_obj_arg) {}
+
+// def InterpreterCache.new : BaseIO InterpreterCache
+extern "C" LEAN_EXPORT obj_res lean_ir_mk_interpreter_cache(obj_arg) {
+    return io_result_mk_ok(lean_alloc_external(g_interpreter_cache_external_class, new interpreter_cache()));
+}
+
+extern "C" object * lean_ir_get_interpreter_cache(object * env);
+/** \brief Return the cache stored in `env`, which lives as long as `env`, or `nullptr` if it has none. */
+static interpreter_cache * get_interpreter_cache(environment const & env) {
+    option_ref<object_ref> c(lean_ir_get_interpreter_cache(env.to_obj_arg()));
+    if (!c) {
+        return nullptr;
+    }
+    return static_cast<interpreter_cache *>(lean_get_external_data(c.get_val().raw()));
+}
+
+/** \brief Call tree of the profiling interpreters (see `interpreter.profile`) of one thread. Each node accumulates the
+    self time and the number of small allocations (as counted by heartbeats) of a call path. Native functions called by
+    interpreted code get their own nodes, and interpreters nested in them extend the current path. The tree is only
+    extended by its thread but may be written by any thread, so `m_mutex` guards `m_nodes`. */
+class call_profile {
+    struct node {
+        name m_fn;
+        uint64 m_time_ns = 0;
+        uint64 m_allocs = 0;
+        name_hash_map<size_t> m_children;
+
+        explicit node(name const & fn) : m_fn(fn) {}
+    };
+    struct frame {
+        size_t m_node;
+        std::chrono::steady_clock::time_point m_start;
+        uint64 m_start_allocs;
+        // totals of returned callees, which are not part of the self totals
+        uint64 m_callee_time_ns;
+        uint64 m_callee_allocs;
+    };
+    mutable mutex m_mutex;
+    // `m_nodes[0]` is the root, which is not part of any path
+    std::vector<node> m_nodes;
+    // only accessed by the owning thread
+    std::vector<frame> m_stack;
+
+    void write(size_t n, std::string const & path, std::ostream & time_out, std::ostream & alloc_out) const {
+        node const & nd = m_nodes[n];
+        std::string p = n == 0 ? path : path.empty() ? nd.m_fn.to_string() : path + ";" + nd.m_fn.to_string();
+        // flame graph tools expect integral counts, so report microseconds
+        if (nd.m_time_ns >= 1000) {
+            time_out << p << " " << nd.m_time_ns / 1000 << "\n";
+        }
+        if (nd.m_allocs > 0) {
+            alloc_out << p << " " << nd.m_allocs << "\n";
+        }
+        for (auto const & c : nd.m_children) {
+            write(c.second, p, time_out, alloc_out);
+        }
+    }
+public:
+    call_profile() { m_nodes.emplace_back(name()); }
+
+    size_t depth() const { return m_stack.size(); }
+
+    void enter(name const & fn) {
+        lock_guard<mutex> _(m_mutex);
+        size_t parent = m_stack.empty() ? 0 : m_stack.back().m_node;
+        auto it = m_nodes[parent].m_children.find(fn);
+        size_t n;
+        if (it != m_nodes[parent].m_children.end()) {
+            n = it->second;
+        } else {
+            n = m_nodes.size();
+            m_nodes[parent].m_children.emplace(fn, n);
+            m_nodes.emplace_back(fn);
+        }
+        m_stack.push_back(frame { n, std::chrono::steady_clock::now(), get_num_heartbeats(), 0, 0 });
+    }
+
+    void leave() {
+        frame f = m_stack.back();
+        m_stack.pop_back();
+        uint64 time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - f.m_start).count();
+        uint64 allocs = get_num_heartbeats() - f.m_start_allocs;
+        lock_guard<mutex> _(m_mutex);
+        m_nodes[f.m_node].m_time_ns += time - std::min(time, f.m_callee_time_ns);
+        m_nodes[f.m_node].m_allocs += allocs - std::min(allocs, f.m_callee_allocs);
+        if (!m_stack.empty()) {
+            m_stack.back().m_callee_time_ns += time;
+            m_stack.back().m_callee_allocs += allocs;
+        }
+    }
+
+    /** \brief Write self times and allocations in the "collapsed stack" format of flame graph tools. */
+    void write(std::ostream & time_out, std::ostream & alloc_out) const {
+        lock_guard<mutex> _(m_mutex);
+        write(0, std::string(), time_out, alloc_out);
+    }
+};
+
+static mutex * g_profiles_mutex = nullptr;
+// profiles of all threads that ran a profiling interpreter, see `save_interpreter_profile`
+static std::vector<call_profile *> * g_profiles = nullptr;
+// output file given by the first profiling interpreter
+static std::string * g_profile_file = nullptr;
+LEAN_THREAD_PTR(call_profile, g_profile);
+
+static call_profile * get_thread_profile(char const * file) {
+    if (!g_profile) {
+        lock_guard<mutex> _(*g_profiles_mutex);
+        g_profile = new call_profile();
+        g_profiles->push_back(g_profile);
+        if (g_profile_file->empty()) {
+            *g_profile_file = file;
+        }
+    }
+    return g_profile;
+}
+
+void save_interpreter_profile() {
+    lock_guard<mutex> _(*g_profiles_mutex);
+    if (g_profile_file->empty()) {
+        return;
+    }
+    std::ofstream time_out(*g_profile_file);
+    std::ofstream alloc_out(*g_profile_file + ".alloc");
+    if (time_out.fail() || alloc_out.fail()) {
+        throw exception(sstream() << "failed to write interpreter profile '" << *g_profile_file << "'");
+    }
+    for (call_profile const * p : *g_profiles) {
+        p->write(time_out, alloc_out);
+    }
+}
+
+// def saveInterpreterProfile : IO Unit
+extern "C" LEAN_EXPORT obj_res lean_ir_save_interpreter_profile(obj_arg) {
+    try {
+        save_interpreter_profile();
+        return io_result_mk_ok(box(0));
+    } catch (exception & ex) {
+        return io_result_mk_error(ex.what());
+    }
+}
+
 class interpreter {
     // stack of IR variable slots
     std::vector<value> m_arg_stack;
-    // stack of join points
-    std::vector<fn_body const *> m_jp_stack;
     struct frame {
         name m_fn;
-        // base pointers into the stack above
+        // base pointer into the stack above
         size_t m_arg_bp;
-        size_t m_jp_bp;
 
-        frame(name const & mFn, size_t mArgBp, size_t mJpBp) : m_fn(mFn), m_arg_bp(mArgBp), m_jp_bp(mJpBp) {}
+        frame(name const & mFn, size_t mArgBp) : m_fn(mFn), m_arg_bp(mArgBp) {}
     };
     std::vector<frame> m_call_stack;
     environment const & m_env;
     options const & m_opts;
     // if `false`, use IR code where possible
     bool m_prefer_native;
-    struct constant_cache_entry {
-      bool m_is_scalar;
-      value m_val;
-    };
+    // number of calls after which imported functions are compiled, or 0; see `check_jit`
+    unsigned m_jit_threshold;
+    // profile of the current thread if `interpreter.profile` is set, and its depth when this interpreter was created
+    call_profile * m_profile;
+    size_t m_profile_depth;
+    // caches of imported declarations shared with other interpreters, see `lookup_symbol` and `load`; `nullptr` if
+    // the environment has none, in which case imported declarations are treated like those of the current module
+    interpreter_cache * m_cache;
     // caches values of nullary functions ("constants")
-    name_map<constant_cache_entry> m_constant_cache;
+    name_hash_map<constant_cache_entry> m_constant_cache;
+
+    struct symbol_cache_entry;
+
+    enum class opcode : uint8 {
+        // `let x := e`, one opcode per kind of `e`; `Num` and `Lit` are unboxed and boxed literals, respectively
+        Ctor, Reset, Reuse, Proj, UProj, SProj, Call, Load, PAp, Ap, Box, Unbox, Num, Lit, IsShared, IsTaggedPtr,
+        // `let x := f ys; ret x` where `f` is the current function
+        TailCall,
+        Set, SetTag, USet, SSet, Inc, Dec, Del, Case, Ret, Jmp, Unreachable,
+        // an instruction ruled out by the IR type system, such as a projection to an irrelevant value
+        Invalid
+    };
+
+    /** \brief Instruction of a `code` object. Variables are referred to by their slot in the stack frame; the meaning of
+        the other operands depends on the opcode. */
+    struct instr {
+        opcode m_op;
+        // type of the declared variable, or of the stored field for `SSet`, or the source type for `Box`
+        type m_type = type::Irrelevant;
+        // `Reuse`: whether to update the constructor tag; `Case`: whether the discriminant is unboxed
+        bool m_flag = false;
+        // declared, updated, or inspected variable
+        uint32 m_x = 0;
+        // source variable or argument
+        uint32 m_y = 0;
+        // field index or byte offset, constructor tag, reference count increment, or jump target
+        uint32 m_i = 0;
+        // number of boxed fields and byte size of the unboxed fields of a constructor
+        uint32 m_num_objs = 0;
+        uint32 m_scalar_size = 0;
+        // arguments, case table, or join point parameter/argument pairs in `code::m_operands`
+        uint32 m_args = 0;
+        uint32 m_num_args = 0;
+        // boxed literal, or name of the function applied by `Call`, `Load`, and `PAp`
+        object * m_obj = nullptr;
+        // unboxed literal
+        value m_val;
+        // entry of the function named by `m_obj`, looked up on first execution
+        mutable symbol_cache_entry * m_callee = nullptr;
+        // IR statement this instruction was decoded from, for tracing
+        object * m_body;
+
+        instr(opcode op, fn_body const & b) : m_op(op), m_body(b.raw()) {}
+    };
+
+    /** \brief Pre-decoded form of an IR function body, created when the function is first interpreted. Statements are
+        laid out sequentially with their continuations, join points and case alternatives are resolved to instruction
+        indices, and constructor and literal data is decoded upfront. */
+    struct code {
+        std::vector<instr> m_instrs;
+        std::vector<uint32> m_operands;
+        // number of variable slots of a stack frame
+        size_t m_frame_size = 0;
+    };
+
     struct symbol_cache_entry {
         decl m_decl;
         // symbol address; `nullptr` if function does not have native code
         void * m_addr;
         // true iff we chose the boxed version of a function where the IR uses the unboxed version
         bool m_boxed;
+        // shared entry if the declaration is imported, so that its value (if it is a constant) may be put in `m_cache`
+        interpreter_cache::symbol_entry * m_shared;
+        // see `get_code`
+        std::unique_ptr<code> m_code;
     };
-    // caches symbol lookup successes _and_ failures
-    name_map<symbol_cache_entry> m_symbol_cache;
+    // caches symbol lookup successes _and_ failures; entries are never removed, so instructions can refer to them
+    name_hash_map<symbol_cache_entry> m_symbol_cache;
 
     /** \brief Get current stack frame */
     inline frame & get_frame() {
         return m_call_stack.back();
     }
 
-    /** \brief Get reference to stack slot of IR variable */
-    inline value & var(var_id const & v) {
-        // variables are 1-indexed
-        size_t i = get_frame().m_arg_bp + v.get_small_value() - 1;
-        // we don't know the frame size (unless we do an additional IR pass), so we extend it dynamically
-        if (i >= m_arg_stack.size()) {
-            m_arg_stack.resize(i + 1);
-        }
-        return m_arg_stack[i];
+    /** \brief Get reference to stack slot `x` of the frame starting at `bp` */
+    inline value & var(size_t bp, uint32 x) {
+        lean_assert(bp + x < m_arg_stack.size());
+        return m_arg_stack[bp + x];
+    }
+
+    inline value eval_arg(size_t bp, uint32 x) {
+        // an "irrelevant" argument is type- or proof-erased; we can use an arbitrary value for it
+        return x == g_irrelevant_slot ? value(box(0)) : var(bp, x);
     }
 
 public:
@@ -381,7 +744,8 @@ public:
             // We changed threads or the closure was stored and called in a different context.
             time_task t("interpretation", opts, fn);
             scope_trace_env scope_trace(env, opts);
-            // the caches contain data from the Environment, so we cannot reuse them when changing it
+            // the local caches contain data from the Environment, so we cannot reuse them when changing it; data
+            // from imported modules is preserved in `interpreter_cache`
             interpreter interp(env, opts);
             flet<interpreter *> fl(g_interpreter, &interp);
             return f(interp);
@@ -389,346 +753,641 @@ public:
     }
 
 private:
-    value eval_arg(arg const & a) {
-        // an "irrelevant" argument is type- or proof-erased; we can use an arbitrary value for it
-        return arg_is_irrelevant(a) ? box(0) : var(arg_var_id(a));
+    // join point in scope while decoding a function body
+    struct jp_scope {
+        size_t m_id;
+        fn_body const * m_jdecl;
+        // `Jmp` instructions to be pointed at the join point body once it has been decoded
+        std::vector<size_t> m_jmps;
+    };
+
+    /** \brief Return stack slot of IR variable, extending the frame if necessary */
+    static uint32 decode_var(code & c, var_id const & x) {
+        // variables are 1-indexed
+        size_t i = x.get_small_value() - 1;
+        c.m_frame_size = std::max(c.m_frame_size, i + 1);
+        return i;
     }
 
-    /** \brief Allocate constructor object with given tag and arguments */
-    object * alloc_ctor(ctor_info const & i, array_ref<arg> const & args) {
-        size_t tag = ctor_info_tag(i).get_small_value();
-        // number of boxed object fields
-        size_t size = ctor_info_size(i).get_small_value();
-        // number of unboxed USize fields (whose byte size the IR is ignorant of)
-        size_t usize = ctor_info_usize(i).get_small_value();
-        // byte size of all other unboxed fields
-        size_t ssize = ctor_info_ssize(i).get_small_value();
-        if (size == 0 && usize == 0 && ssize == 0) {
-            // a constructor without data is optimized to a tagged pointer
-            return box(tag);
-        } else {
-            object *o = alloc_cnstr(tag, size, usize * sizeof(void *) + ssize);
-            for (size_t i = 0; i < args.size(); i++) {
-                cnstr_set(o, i, eval_arg(args[i]).m_obj);
-            }
-            return o;
+    static uint32 decode_arg(code & c, arg const & a) {
+        return arg_is_irrelevant(a) ? g_irrelevant_slot : decode_var(c, arg_var_id(a));
+    }
+
+    static void decode_args(code & c, instr & i, array_ref<arg> const & args) {
+        i.m_args = c.m_operands.size();
+        i.m_num_args = args.size();
+        for (arg const & a : args) {
+            c.m_operands.push_back(decode_arg(c, a));
         }
     }
 
-    /** \brief Return closure pointing to interpreter stub taking interpreter data, declaration to be called, and partially
-        applied arguments. */
-    object * mk_stub_closure(decl const & d, unsigned n, object ** args) {
-        unsigned cls_size = 3 + decl_params(d).size();
-        object * cls = alloc_closure(get_stub(cls_size), cls_size, 3 + n);
-        closure_set(cls, 0, m_env.to_obj_arg());
-        closure_set(cls, 1, m_opts.to_obj_arg());
-        closure_set(cls, 2, d.to_obj_arg());
-        for (unsigned i = 0; i < n ; i++)
-            closure_set(cls, 3 + i, args[i]);
-        return cls;
+    static void decode_ctor_info(instr & i, ctor_info const & info) {
+        i.m_i = ctor_info_tag(info).get_small_value();
+        i.m_num_objs = ctor_info_size(info).get_small_value();
+        // the IR is ignorant of the byte size of USize fields
+        i.m_scalar_size = ctor_info_usize(info).get_small_value() * sizeof(void *) + ctor_info_ssize(info).get_small_value();
     }
 
-    value eval_expr(expr const & e, type t) {
+    static bool is_supported_scalar_field(type t) {
+        return t == type::Float || t == type::UInt8 || t == type::UInt16 || t == type::UInt32 || t == type::UInt64;
+    }
+
+    /** \brief Decode `let x : t := e; ...` with `e` not a tail call */
+    static instr decode_vdecl(code & c, fn_body const & b) {
+        expr const & e = fn_body_vdecl_expr(b);
+        type t = fn_body_vdecl_type(b);
+        instr i(opcode::Invalid, b);
+        i.m_type = t;
+        i.m_x = decode_var(c, fn_body_vdecl_var(b));
         switch (expr_tag(e)) {
             case expr_kind::Ctor:
-                return value { alloc_ctor(expr_ctor_info(e), expr_ctor_args(e)) };
-            case expr_kind::Reset: { // release fields if unique reference in preparation for `Reuse` below
-                object * o = var(expr_reset_obj(e)).m_obj;
-                if (is_exclusive(o)) {
-                    for (size_t i = 0; i < expr_reset_num_objs(e).get_small_value(); i++) {
-                        cnstr_release(o, i);
-                    }
-                    return o;
-                } else {
-                    dec_ref(o);
-                    return box(0);
-                }
-            }
-            case expr_kind::Reuse: { // reuse dead allocation if possible
-                object * o = var(expr_reuse_obj(e)).m_obj;
-                // check if `Reset` above had a unique reference it consumed
-                if (is_scalar(o)) {
-                    // fall back to regular allocation
-                    return alloc_ctor(expr_reuse_ctor(e), expr_reuse_args(e));
+                decode_ctor_info(i, expr_ctor_info(e));
+                if (i.m_num_objs == 0 && i.m_scalar_size == 0) {
+                    // a constructor without data is optimized to a tagged pointer
+                    i.m_op = opcode::Lit;
+                    i.m_obj = box(i.m_i);
                 } else {
-                    // create new constructor object in-place
-                    if (expr_reuse_update_header(e)) {
-                        cnstr_set_tag(o, ctor_info_tag(expr_reuse_ctor(e)).get_small_value());
-                    }
-                    for (size_t i = 0; i < expr_reuse_args(e).size(); i++) {
-                        cnstr_set(o, i, eval_arg(expr_reuse_args(e)[i]).m_obj);
-                    }
-                    return o;
+                    i.m_op = opcode::Ctor;
+                    decode_args(c, i, expr_ctor_args(e));
                 }
-            }
-            case expr_kind::Proj: // object field access
-                return cnstr_get(var(expr_proj_obj(e)).m_obj, expr_proj_idx(e).get_small_value());
-            case expr_kind::UProj: // USize field access
-                return cnstr_get_usize(var(expr_uproj_obj(e)).m_obj, expr_uproj_idx(e).get_small_value());
-            case expr_kind::SProj: { // other unboxed field access
-                size_t offset = expr_sproj_idx(e).get_small_value() * sizeof(void *) +
-                                expr_sproj_offset(e).get_small_value();
-                object * o = var(expr_sproj_obj(e)).m_obj;
-                switch (t) {
-                    case type::Float: return value::from_float(cnstr_get_float(o, offset));
-                    case type::UInt8: return cnstr_get_uint8(o, offset);
-                    case type::UInt16: return cnstr_get_uint16(o, offset);
-                    case type::UInt32: return cnstr_get_uint32(o, offset);
-                    case type::UInt64: return cnstr_get_uint64(o, offset);
-                    case type::USize:
-                    case type::Irrelevant:
-                    case type::Object:
-                    case type::TObject:
-                        break;
+                break;
+            case expr_kind::Reset:
+                i.m_op = opcode::Reset;
+                i.m_y = decode_var(c, expr_reset_obj(e));
+                i.m_num_objs = expr_reset_num_objs(e).get_small_value();
+                break;
+            case expr_kind::Reuse:
+                i.m_op = opcode::Reuse;
+                i.m_y = decode_var(c, expr_reuse_obj(e));
+                i.m_flag = expr_reuse_update_header(e);
+                decode_ctor_info(i, expr_reuse_ctor(e));
+                decode_args(c, i, expr_reuse_args(e));
+                break;
+            case expr_kind::Proj:
+                i.m_op = opcode::Proj;
+                i.m_y = decode_var(c, expr_proj_obj(e));
+                i.m_i = expr_proj_idx(e).get_small_value();
+                break;
+            case expr_kind::UProj:
+                i.m_op = opcode::UProj;
+                i.m_y = decode_var(c, expr_uproj_obj(e));
+                i.m_i = expr_uproj_idx(e).get_small_value();
+                break;
+            case expr_kind::SProj:
+                if (is_supported_scalar_field(t)) {
+                    i.m_op = opcode::SProj;
+                    i.m_y = decode_var(c, expr_sproj_obj(e));
+                    i.m_i = expr_sproj_idx(e).get_small_value() * sizeof(void *) + expr_sproj_offset(e).get_small_value();
                 }
-                throw exception("invalid instruction");
-            }
-            case expr_kind::FAp: { // satured ("full") application of top-level function
+                break;
+            case expr_kind::FAp:
+                i.m_obj = expr_fap_fun(e).raw();
                 if (expr_fap_args(e).size()) {
-                    return call(expr_fap_fun(e), expr_fap_args(e));
+                    i.m_op = opcode::Call;
+                    decode_args(c, i, expr_fap_args(e));
                 } else {
                     // nullary function ("constant")
-                    return load(expr_fap_fun(e), t);
+                    i.m_op = opcode::Load;
                 }
-            }
-            case expr_kind::PAp: { // unsatured (partial) application of top-level function
-                symbol_cache_entry sym = lookup_symbol(expr_pap_fun(e));
-                if (sym.m_addr) {
-                    // point closure directly at native symbol
-                    object * cls = alloc_closure(sym.m_addr, decl_params(sym.m_decl).size(), expr_pap_args(e).size());
-                    for (unsigned i = 0; i < expr_pap_args(e).size(); i++) {
-                        closure_set(cls, i, eval_arg(expr_pap_args(e)[i]).m_obj);
-                    }
-                    return cls;
-                } else {
-                    // point closure at interpreter stub
-                    object ** args = static_cast<object **>(LEAN_ALLOCA(expr_pap_args(e).size() * sizeof(object *))); // NOLINT
-                    for (size_t i = 0; i < expr_pap_args(e).size(); i++) {
-                        args[i] = eval_arg(expr_pap_args(e)[i]).m_obj;
-                    }
-                    return mk_stub_closure(sym.m_decl, expr_pap_args(e).size(), args);
-                }
-            }
-            case expr_kind::Ap: { // (saturated or unsatured) application of closure; mostly handled by runtime
-                object ** args = static_cast<object **>(LEAN_ALLOCA(expr_ap_args(e).size() * sizeof(object *))); // NOLINT
-                for (size_t i = 0; i < expr_ap_args(e).size(); i++) {
-                    args[i] = eval_arg(expr_ap_args(e)[i]).m_obj;
-                }
-                object * r = apply_n(var(expr_ap_fun(e)).m_obj, expr_ap_args(e).size(), args);
-                return r;
-            }
-            case expr_kind::Box: // box unboxed value
-                return box_t(var(expr_box_obj(e)).m_num, expr_box_type(e));
-            case expr_kind::Unbox: // unbox boxed value
-                return unbox_t(var(expr_unbox_obj(e)).m_obj, t);
-            case expr_kind::Lit: // load numeric or string literal
+                break;
+            case expr_kind::PAp:
+                i.m_op = opcode::PAp;
+                i.m_obj = expr_pap_fun(e).raw();
+                decode_args(c, i, expr_pap_args(e));
+                break;
+            case expr_kind::Ap:
+                i.m_op = opcode::Ap;
+                i.m_y = decode_var(c, expr_ap_fun(e));
+                decode_args(c, i, expr_ap_args(e));
+                break;
+            case expr_kind::Box:
+                i.m_op = opcode::Box;
+                i.m_type = expr_box_type(e);
+                i.m_y = decode_var(c, expr_box_obj(e));
+                break;
+            case expr_kind::Unbox:
+                i.m_op = opcode::Unbox;
+                i.m_y = decode_var(c, expr_unbox_obj(e));
+                break;
+            case expr_kind::Lit:
                 switch (lit_val_tag(expr_lit_val(e))) {
                     case lit_val_kind::Num: {
                         nat const & n = lit_val_num(expr_lit_val(e));
+                        i.m_op = opcode::Num;
                         switch (t) {
                             case type::Float:
                                 lean_inc(n.raw());
-                                return value::from_float(lean_float_of_nat(n.raw()));
+                                i.m_val = value::from_float(lean_float_of_nat(n.raw()));
+                                break;
                             case type::UInt8:
                             case type::UInt16:
                             case type::UInt32:
                             case type::USize:
-                                return lean_usize_of_nat(n.raw());
+                                i.m_val = lean_usize_of_nat(n.raw());
+                                break;
                             case type::UInt64:
-                                return lean_uint64_of_nat(n.raw());
+                                i.m_val = lean_uint64_of_nat(n.raw());
+                                break;
                             // `nat` literal
                             case type::Object:
                             case type::TObject:
-                                return n.to_obj_arg();
+                                i.m_op = opcode::Lit;
+                                i.m_obj = n.raw();
+                                break;
                             case type::Irrelevant:
+                                i.m_op = opcode::Invalid;
                                 break;
                         }
-                        throw exception("invalid instruction");
+                        break;
                     }
                     case lit_val_kind::Str:
-                        return lit_val_str(expr_lit_val(e)).to_obj_arg();
+                        i.m_op = opcode::Lit;
+                        i.m_obj = lit_val_str(expr_lit_val(e)).raw();
+                        break;
                 }
                 break;
             case expr_kind::IsShared:
-                return !is_exclusive(var(expr_is_shared_obj(e)).m_obj);
+                i.m_op = opcode::IsShared;
+                i.m_y = decode_var(c, expr_is_shared_obj(e));
+                break;
             case expr_kind::IsTaggedPtr:
-                return !is_scalar(var(expr_is_tagged_ptr_obj(e)).m_obj);
-        }
-        throw exception(sstream() << "unexpected instruction kind " << static_cast<unsigned>(expr_tag(e)));
-    }
-
-    void check_system() {
-        try {
-            lean::check_system("interpreter");
-        } catch (stack_space_exception & ex) {
-            sstream ss;
-            ss << ex.what() << "\n";
-            ss << "interpreter stacktrace:\n";
-            for (unsigned i = 0; i < m_call_stack.size(); i++) {
-                ss << "#" << (i + 1) << " " << m_call_stack[m_call_stack.size() - i - 1].m_fn << "\n";
-            }
-            throw throwable(ss);
+                i.m_op = opcode::IsTaggedPtr;
+                i.m_y = decode_var(c, expr_is_tagged_ptr_obj(e));
+                break;
         }
+        return i;
     }
 
-    value eval_body(fn_body const & b0) {
-        check_system();
-
-        // make reference reassignable...
-        std::reference_wrapper<fn_body const> b(b0);
+    /** \brief Append the instructions of `b`, a body of the function `fn`, to `c`. */
+    static void decode_body(code & c, fn_body const & b0, name const & fn, std::vector<jp_scope> & jps) {
+        fn_body const * b = &b0;
         while (true) {
-            DEBUG_CODE(lean_trace(name({"interpreter", "step"}),
-                                  tout() << std::string(m_call_stack.size(), ' ') << format_fn_body_head(b) << "\n";);)
-            switch (fn_body_tag(b)) {
+            switch (fn_body_tag(*b)) {
                 case fn_body_kind::VDecl: { // variable declaration
-                    expr const & e = fn_body_vdecl_expr(b);
-                    fn_body const & cont = fn_body_vdecl_cont(b);
-                    // tail recursion?
-                    if (expr_tag(e) == expr_kind::FAp && expr_fap_fun(e) == get_frame().m_fn &&
+                    expr const & e = fn_body_vdecl_expr(*b);
+                    fn_body const & cont = fn_body_vdecl_cont(*b);
+                    if (expr_tag(e) == expr_kind::FAp && expr_fap_fun(e) == fn &&
                         fn_body_tag(cont) == fn_body_kind::Ret && !arg_is_irrelevant(fn_body_ret_arg(cont)) &&
-                        arg_var_id(fn_body_ret_arg(cont)) == fn_body_vdecl_var(b)) {
-                        // tail recursion! copy argument values to parameter slots and reset `b`
-                        array_ref<arg> const & args = expr_fap_args(e);
-                        // argument and parameter slots may overlap, so first copy arguments to end of stack
-                        size_t old_size = m_arg_stack.size();
-                        for (const auto & arg : args) {
-                            m_arg_stack.push_back(eval_arg(arg));
-                        }
-                        // now copy to parameter slots
-                        for (size_t i = 0; i < args.size(); i++) {
-                            m_arg_stack[get_frame().m_arg_bp + i] = m_arg_stack[old_size + i];
-                        }
-                        m_arg_stack.resize(get_frame().m_arg_bp + args.size());
-                        b = b0;
-                        check_system();
-                        break;
+                        arg_var_id(fn_body_ret_arg(cont)) == fn_body_vdecl_var(*b)) {
+                        // tail recursion
+                        instr i(opcode::TailCall, *b);
+                        decode_args(c, i, expr_fap_args(e));
+                        c.m_instrs.push_back(i);
+                        return;
                     }
-                    value v = eval_expr(fn_body_vdecl_expr(b), fn_body_vdecl_type(b));
-                    // NOTE: `var` must be called *after* `eval_expr` because the stack may get resized and invalidate
-                    // the pointer
-                    var(fn_body_vdecl_var(b)) = v;
-                    DEBUG_CODE(lean_trace(name({"interpreter", "step"}),
-                                          tout() << std::string(m_call_stack.size(), ' ') << "=> x_";
-                                          tout() << fn_body_vdecl_var(b).get_small_value() << " = ";
-                                          print_value(tout(), var(fn_body_vdecl_var(b)), fn_body_vdecl_type(b));
-                                          tout() << "\n";);)
-                    b = fn_body_vdecl_cont(b);
+                    c.m_instrs.push_back(decode_vdecl(c, *b));
+                    b = &cont;
                     break;
                 }
-                case fn_body_kind::JDecl: { // join-point declaration; store in stack slot just like variables
-                    size_t i = get_frame().m_jp_bp + fn_body_jdecl_id(b).get_small_value();
-                    if (i >= m_jp_stack.size()) {
-                        m_jp_stack.resize(i + 1);
+                case fn_body_kind::JDecl: { // join-point declaration; its body is placed after the continuation
+                    for (param const & p : fn_body_jdecl_params(*b)) {
+                        decode_var(c, param_var(p));
+                    }
+                    jps.push_back(jp_scope { fn_body_jdecl_id(*b).get_small_value(), b, {} });
+                    decode_body(c, fn_body_jdecl_cont(*b), fn, jps);
+                    jp_scope jp = std::move(jps.back());
+                    jps.pop_back();
+                    uint32 target = c.m_instrs.size();
+                    for (size_t j : jp.m_jmps) {
+                        c.m_instrs[j].m_i = target;
                     }
-                    m_jp_stack[i] = &b.get();
-                    b = fn_body_jdecl_cont(b);
+                    b = &fn_body_jdecl_body(*jp.m_jdecl);
                     break;
                 }
                 case fn_body_kind::Set: { // set boxed field of unique reference
-                    object * o = var(fn_body_set_var(b)).m_obj;
-                    lean_assert(is_exclusive(o));
-                    cnstr_set(o, fn_body_set_idx(b).get_small_value(), eval_arg(fn_body_set_arg(b)).m_obj);
-                    b = fn_body_set_cont(b);
+                    instr i(opcode::Set, *b);
+                    i.m_x = decode_var(c, fn_body_set_var(*b));
+                    i.m_i = fn_body_set_idx(*b).get_small_value();
+                    i.m_y = decode_arg(c, fn_body_set_arg(*b));
+                    c.m_instrs.push_back(i);
+                    b = &fn_body_set_cont(*b);
                     break;
                 }
                 case fn_body_kind::SetTag: { // set constructor tag of unique reference
-                    object * o = var(fn_body_set_tag_var(b)).m_obj;
-                    lean_assert(is_exclusive(o));
-                    cnstr_set_tag(o, fn_body_set_tag_cidx(b).get_small_value());
-                    b = fn_body_set_tag_cont(b);
+                    instr i(opcode::SetTag, *b);
+                    i.m_x = decode_var(c, fn_body_set_tag_var(*b));
+                    i.m_i = fn_body_set_tag_cidx(*b).get_small_value();
+                    c.m_instrs.push_back(i);
+                    b = &fn_body_set_tag_cont(*b);
                     break;
                 }
                 case fn_body_kind::USet: { // set USize field of unique reference
-                    object * o = var(fn_body_uset_target(b)).m_obj;
-                    lean_assert(is_exclusive(o));
-                    cnstr_set_usize(o, fn_body_uset_idx(b).get_small_value(), var(fn_body_uset_source(b)).m_num);
-                    b = fn_body_uset_cont(b);
+                    instr i(opcode::USet, *b);
+                    i.m_x = decode_var(c, fn_body_uset_target(*b));
+                    i.m_i = fn_body_uset_idx(*b).get_small_value();
+                    i.m_y = decode_var(c, fn_body_uset_source(*b));
+                    c.m_instrs.push_back(i);
+                    b = &fn_body_uset_cont(*b);
                     break;
                 }
                 case fn_body_kind::SSet: { // set other unboxed field of unique reference
-                    object * o = var(fn_body_sset_target(b)).m_obj;
-                    size_t offset = fn_body_sset_idx(b).get_small_value() * sizeof(void *) +
-                                    fn_body_sset_offset(b).get_small_value();
-                    value v = var(fn_body_sset_source(b));
-                    lean_assert(is_exclusive(o));
-                    switch (fn_body_sset_type(b)) {
-                        case type::Float: cnstr_set_float(o, offset, v.m_float); break;
-                        case type::UInt8: cnstr_set_uint8(o, offset, v.m_num); break;
-                        case type::UInt16: cnstr_set_uint16(o, offset, v.m_num); break;
-                        case type::UInt32: cnstr_set_uint32(o, offset, v.m_num); break;
-                        case type::UInt64: cnstr_set_uint64(o, offset, v.m_num); break;
-                        case type::USize:
-                        case type::Irrelevant:
-                        case type::Object:
-                        case type::TObject:
-                            throw exception(sstream() << "invalid instruction");
+                    instr i(opcode::Invalid, *b);
+                    i.m_type = fn_body_sset_type(*b);
+                    if (is_supported_scalar_field(i.m_type)) {
+                        i.m_op = opcode::SSet;
+                        i.m_x = decode_var(c, fn_body_sset_target(*b));
+                        i.m_i = fn_body_sset_idx(*b).get_small_value() * sizeof(void *) +
+                                fn_body_sset_offset(*b).get_small_value();
+                        i.m_y = decode_var(c, fn_body_sset_source(*b));
                     }
-                    b = fn_body_sset_cont(b);
+                    c.m_instrs.push_back(i);
+                    b = &fn_body_sset_cont(*b);
                     break;
                 }
-                case fn_body_kind::Inc: // increment reference counter
-                    inc(var(fn_body_inc_var(b)).m_obj, fn_body_inc_val(b).get_small_value());
-                    b = fn_body_inc_cont(b);
+                case fn_body_kind::Inc: { // increment reference counter
+                    instr i(opcode::Inc, *b);
+                    i.m_x = decode_var(c, fn_body_inc_var(*b));
+                    i.m_i = fn_body_inc_val(*b).get_small_value();
+                    c.m_instrs.push_back(i);
+                    b = &fn_body_inc_cont(*b);
                     break;
+                }
                 case fn_body_kind::Dec: { // decrement reference counter
-                    size_t n = fn_body_dec_val(b).get_small_value();
-                    for (size_t i = 0; i < n; i++) {
-                        dec(var(fn_body_dec_var(b)).m_obj);
-                    }
-                    b = fn_body_dec_cont(b);
+                    instr i(opcode::Dec, *b);
+                    i.m_x = decode_var(c, fn_body_dec_var(*b));
+                    i.m_i = fn_body_dec_val(*b).get_small_value();
+                    c.m_instrs.push_back(i);
+                    b = &fn_body_dec_cont(*b);
                     break;
                 }
-                case fn_body_kind::Del: // delete object of unique reference
-                    lean_free_object(var(fn_body_del_var(b)).m_obj);
-                    b = fn_body_del_cont(b);
+                case fn_body_kind::Del: { // delete object of unique reference
+                    instr i(opcode::Del, *b);
+                    i.m_x = decode_var(c, fn_body_del_var(*b));
+                    c.m_instrs.push_back(i);
+                    b = &fn_body_del_cont(*b);
                     break;
+                }
                 case fn_body_kind::MData: // metadata; no-op
-                    b = fn_body_mdata_cont(b);
+                    b = &fn_body_mdata_cont(*b);
                     break;
                 case fn_body_kind::Case: { // branch according to constructor tag
-                    array_ref<alt_core> const & alts = fn_body_case_alts(b);
-                    unsigned tag;
-                    value v = var(fn_body_case_var(b));
-                    if (type_is_scalar(fn_body_case_var_type(b))) {
-                        tag = v.m_num;
-                    } else {
-                        tag = lean_obj_tag(v.m_obj);
+                    array_ref<alt_core> const & alts = fn_body_case_alts(*b);
+                    instr i(opcode::Case, *b);
+                    i.m_x = decode_var(c, fn_body_case_var(*b));
+                    i.m_flag = type_is_scalar(fn_body_case_var_type(*b));
+                    i.m_i = g_no_target;
+                    size_t num_tags = 0;
+                    for (alt_core const & a : alts) {
+                        if (alt_core_tag(a) == alt_core_kind::Ctor) {
+                            num_tags = std::max(num_tags, ctor_info_tag(alt_core_ctor_info(a)).get_small_value() + 1);
+                        }
                     }
+                    // dense table from tags to alternatives; tags beyond its end go to the default alternative `m_i`
+                    i.m_args = c.m_operands.size();
+                    i.m_num_args = num_tags;
+                    c.m_operands.resize(c.m_operands.size() + num_tags, g_no_target);
+                    size_t case_idx = c.m_instrs.size();
+                    c.m_instrs.push_back(i);
                     for (alt_core const & a : alts) {
-                        switch (alt_core_tag(a)) {
-                            case alt_core_kind::Ctor:
-                                if (tag == ctor_info_tag(alt_core_ctor_info(a)).get_small_value()) {
-                                    b = alt_core_ctor_cont(a);
-                                    goto done;
+                        uint32 target = c.m_instrs.size();
+                        if (alt_core_tag(a) == alt_core_kind::Ctor) {
+                            uint32 & entry = c.m_operands[i.m_args + ctor_info_tag(alt_core_ctor_info(a)).get_small_value()];
+                            // alternatives are tried in order, so a second one for the same tag is dead
+                            if (entry == g_no_target) {
+                                entry = target;
+                                decode_body(c, alt_core_ctor_cont(a), fn, jps);
+                            }
+                        } else {
+                            // alternatives after the default one are dead
+                            c.m_instrs[case_idx].m_i = target;
+                            for (size_t t = 0; t < num_tags; t++) {
+                                if (c.m_operands[i.m_args + t] == g_no_target) {
+                                    c.m_operands[i.m_args + t] = target;
                                 }
-                                break;
-                            case alt_core_kind::Default:
-                                b = alt_core_default_cont(a);
-                                goto done;
+                            }
+                            decode_body(c, alt_core_default_cont(a), fn, jps);
+                            break;
                         }
                     }
-                    throw exception("incomplete case");
-                    done: break;
+                    return;
+                }
+                case fn_body_kind::Ret: {
+                    instr i(opcode::Ret, *b);
+                    i.m_y = decode_arg(c, fn_body_ret_arg(*b));
+                    c.m_instrs.push_back(i);
+                    return;
                 }
-                case fn_body_kind::Ret:
-                    return eval_arg(fn_body_ret_arg(b));
                 case fn_body_kind::Jmp: { // jump to join-point
-                    fn_body const & jp = *m_jp_stack[get_frame().m_jp_bp + fn_body_jmp_jp(b).get_small_value()];
-                    lean_assert(fn_body_jdecl_params(jp).size() == fn_body_jmp_args(b).size());
-                    for (size_t i = 0; i < fn_body_jdecl_params(jp).size(); i++) {
-                        var(param_var(fn_body_jdecl_params(jp)[i])) = eval_arg(fn_body_jmp_args(b)[i]);
+                    size_t id = fn_body_jmp_jp(*b).get_small_value();
+                    auto jp = std::find_if(jps.rbegin(), jps.rend(), [&](jp_scope const & s) { return s.m_id == id; });
+                    if (jp == jps.rend()) {
+                        throw exception(sstream() << "unknown join point in '" << fn << "'");
                     }
-                    b = fn_body_jdecl_body(jp);
-                    break;
+                    array_ref<param> const & params = fn_body_jdecl_params(*jp->m_jdecl);
+                    array_ref<arg> const & args = fn_body_jmp_args(*b);
+                    lean_assert(params.size() == args.size());
+                    instr i(opcode::Jmp, *b);
+                    i.m_args = c.m_operands.size();
+                    i.m_num_args = args.size();
+                    for (size_t k = 0; k < args.size(); k++) {
+                        c.m_operands.push_back(decode_var(c, param_var(params[k])));
+                        c.m_operands.push_back(decode_arg(c, args[k]));
+                    }
+                    jp->m_jmps.push_back(c.m_instrs.size());
+                    c.m_instrs.push_back(i);
+                    return;
                 }
                 case fn_body_kind::Unreachable:
+                    c.m_instrs.push_back(instr(opcode::Unreachable, *b));
+                    return;
+            }
+        }
+    }
+
+    /** \brief Return pre-decoded body of an interpreted function, decoding it on first use. */
+    code const & get_code(symbol_cache_entry & e) {
+        if (!e.m_code) {
+            std::unique_ptr<code> c(new code());
+            for (param const & p : decl_params(e.m_decl)) {
+                decode_var(*c, param_var(p));
+            }
+            std::vector<jp_scope> jps;
+            decode_body(*c, decl_fun_body(e.m_decl), decl_fun_id(e.m_decl), jps);
+            e.m_code = std::move(c);
+        }
+        return *e.m_code;
+    }
+
+    symbol_cache_entry & get_callee(instr const & i) {
+        if (!i.m_callee) {
+            i.m_callee = &lookup_symbol(TO_REF(name, i.m_obj));
+        }
+        return *i.m_callee;
+    }
+
+    /** \brief Allocate constructor object with given tag and arguments */
+    object * alloc_ctor(instr const & i, uint32 const * args, size_t bp) {
+        if (i.m_num_objs == 0 && i.m_scalar_size == 0) {
+            // a constructor without data is optimized to a tagged pointer
+            return box(i.m_i);
+        } else {
+            object * o = alloc_cnstr(i.m_i, i.m_num_objs, i.m_scalar_size);
+            for (size_t k = 0; k < i.m_num_args; k++) {
+                cnstr_set(o, k, eval_arg(bp, args[k]).m_obj);
+            }
+            return o;
+        }
+    }
+
+    /** \brief Return closure pointing to interpreter stub taking interpreter data, declaration to be called, and partially
+        applied arguments. */
+    object * mk_stub_closure(decl const & d, unsigned n, object ** args) {
+        unsigned cls_size = 3 + decl_params(d).size();
+        object * cls = alloc_closure(get_stub(cls_size), cls_size, 3 + n);
+        closure_set(cls, 0, m_env.to_obj_arg());
+        closure_set(cls, 1, m_opts.to_obj_arg());
+        closure_set(cls, 2, d.to_obj_arg());
+        for (unsigned i = 0; i < n ; i++)
+            closure_set(cls, 3 + i, args[i]);
+        return cls;
+    }
+
+    // NOTE: the helpers below use `alloca` and thus must not be inlined into the loop of `eval_body`
+
+    /** \brief Unsatured (partial) application of top-level function */
+    object * eval_pap(instr const & i, uint32 const * args, size_t bp) {
+        symbol_cache_entry & e = get_callee(i);
+        if (e.m_addr) {
+            // point closure directly at native symbol
+            object * cls = alloc_closure(e.m_addr, decl_params(e.m_decl).size(), i.m_num_args);
+            for (unsigned k = 0; k < i.m_num_args; k++) {
+                closure_set(cls, k, eval_arg(bp, args[k]).m_obj);
+            }
+            return cls;
+        } else {
+            // point closure at interpreter stub
+            object ** args2 = static_cast<object **>(LEAN_ALLOCA(i.m_num_args * sizeof(object *))); // NOLINT
+            for (size_t k = 0; k < i.m_num_args; k++) {
+                args2[k] = eval_arg(bp, args[k]).m_obj;
+            }
+            return mk_stub_closure(e.m_decl, i.m_num_args, args2);
+        }
+    }
+
+    /** \brief (Saturated or unsatured) application of closure; mostly handled by runtime */
+    object * eval_ap(instr const & i, uint32 const * args, size_t bp) {
+        object ** args2 = static_cast<object **>(LEAN_ALLOCA(i.m_num_args * sizeof(object *))); // NOLINT
+        for (size_t k = 0; k < i.m_num_args; k++) {
+            args2[k] = eval_arg(bp, args[k]).m_obj;
+        }
+        return apply_n(var(bp, i.m_y).m_obj, i.m_num_args, args2);
+    }
+
+    void check_system() {
+        try {
+            lean::check_system("interpreter");
+        } catch (stack_space_exception & ex) {
+            sstream ss;
+            ss << ex.what() << "\n";
+            ss << "interpreter stacktrace:\n";
+            for (unsigned i = 0; i < m_call_stack.size(); i++) {
+                ss << "#" << (i + 1) << " " << m_call_stack[m_call_stack.size() - i - 1].m_fn << "\n";
+            }
+            throw throwable(ss);
+        }
+    }
+
+    /** \brief Execute `c` in the current stack frame. */
+    value eval_body(code const & c) {
+        check_system();
+
+        size_t bp = get_frame().m_arg_bp;
+        instr const * instrs = c.m_instrs.data();
+        uint32 const * operands = c.m_operands.data();
+        instr const * pc = instrs;
+        while (true) {
+            DEBUG_CODE(lean_trace(name({"interpreter", "step"}),
+                                  tout() << std::string(m_call_stack.size(), ' ') << format_fn_body_head(TO_REF(fn_body, pc->m_body)) << "\n";);)
+            uint32 const * args = operands + pc->m_args;
+            // value of the variable declared by `pc`
+            value r;
+            switch (pc->m_op) {
+                case opcode::Ctor:
+                    r = alloc_ctor(*pc, args, bp);
+                    break;
+                case opcode::Reset: { // release fields if unique reference in preparation for `Reuse` below
+                    object * o = var(bp, pc->m_y).m_obj;
+                    if (is_exclusive(o)) {
+                        for (size_t i = 0; i < pc->m_num_objs; i++) {
+                            cnstr_release(o, i);
+                        }
+                        r = o;
+                    } else {
+                        dec_ref(o);
+                        r = box(0);
+                    }
+                    break;
+                }
+                case opcode::Reuse: { // reuse dead allocation if possible
+                    object * o = var(bp, pc->m_y).m_obj;
+                    // check if `Reset` above had a unique reference it consumed
+                    if (is_scalar(o)) {
+                        // fall back to regular allocation
+                        r = alloc_ctor(*pc, args, bp);
+                    } else {
+                        // create new constructor object in-place
+                        if (pc->m_flag) {
+                            cnstr_set_tag(o, pc->m_i);
+                        }
+                        for (size_t i = 0; i < pc->m_num_args; i++) {
+                            cnstr_set(o, i, eval_arg(bp, args[i]).m_obj);
+                        }
+                        r = o;
+                    }
+                    break;
+                }
+                case opcode::Proj: // object field access
+                    r = cnstr_get(var(bp, pc->m_y).m_obj, pc->m_i);
+                    break;
+                case opcode::UProj: // USize field access
+                    r = cnstr_get_usize(var(bp, pc->m_y).m_obj, pc->m_i);
+                    break;
+                case opcode::SProj: { // other unboxed field access
+                    object * o = var(bp, pc->m_y).m_obj;
+                    switch (pc->m_type) {
+                        case type::Float: r = value::from_float(cnstr_get_float(o, pc->m_i)); break;
+                        case type::UInt8: r = cnstr_get_uint8(o, pc->m_i); break;
+                        case type::UInt16: r = cnstr_get_uint16(o, pc->m_i); break;
+                        case type::UInt32: r = cnstr_get_uint32(o, pc->m_i); break;
+                        case type::UInt64: r = cnstr_get_uint64(o, pc->m_i); break;
+                        default: lean_unreachable();
+                    }
+                    break;
+                }
+                case opcode::Call: // satured ("full") application of top-level function
+                    r = call(get_callee(*pc), args, pc->m_num_args, bp);
+                    break;
+                case opcode::Load: // nullary function ("constant")
+                    r = load(TO_REF(name, pc->m_obj), pc->m_type);
+                    break;
+                case opcode::PAp:
+                    r = eval_pap(*pc, args, bp);
+                    break;
+                case opcode::Ap:
+                    r = eval_ap(*pc, args, bp);
+                    break;
+                case opcode::Box: // box unboxed value
+                    r = box_t(var(bp, pc->m_y), pc->m_type);
+                    break;
+                case opcode::Unbox: // unbox boxed value
+                    r = unbox_t(var(bp, pc->m_y).m_obj, pc->m_type);
+                    break;
+                case opcode::Num: // unboxed numeric literal
+                    r = pc->m_val;
+                    break;
+                case opcode::Lit: // string, `nat`, or constructor literal
+                    lean_inc(pc->m_obj);
+                    r = pc->m_obj;
+                    break;
+                case opcode::IsShared:
+                    r = !is_exclusive(var(bp, pc->m_y).m_obj);
+                    break;
+                case opcode::IsTaggedPtr:
+                    r = !is_scalar(var(bp, pc->m_y).m_obj);
+                    break;
+                case opcode::TailCall: {
+                    // argument and parameter slots may overlap, so first copy arguments to end of stack
+                    size_t old_size = m_arg_stack.size();
+                    for (size_t i = 0; i < pc->m_num_args; i++) {
+                        m_arg_stack.push_back(eval_arg(bp, args[i]));
+                    }
+                    // now copy to parameter slots
+                    for (size_t i = 0; i < pc->m_num_args; i++) {
+                        m_arg_stack[bp + i] = m_arg_stack[old_size + i];
+                    }
+                    m_arg_stack.resize(old_size);
+                    pc = instrs;
+                    check_system();
+                    continue;
+                }
+                case opcode::Set: { // set boxed field of unique reference
+                    object * o = var(bp, pc->m_x).m_obj;
+                    lean_assert(is_exclusive(o));
+                    cnstr_set(o, pc->m_i, eval_arg(bp, pc->m_y).m_obj);
+                    pc++;
+                    continue;
+                }
+                case opcode::SetTag: { // set constructor tag of unique reference
+                    object * o = var(bp, pc->m_x).m_obj;
+                    lean_assert(is_exclusive(o));
+                    cnstr_set_tag(o, pc->m_i);
+                    pc++;
+                    continue;
+                }
+                case opcode::USet: { // set USize field of unique reference
+                    object * o = var(bp, pc->m_x).m_obj;
+                    lean_assert(is_exclusive(o));
+                    cnstr_set_usize(o, pc->m_i, var(bp, pc->m_y).m_num);
+                    pc++;
+                    continue;
+                }
+                case opcode::SSet: { // set other unboxed field of unique reference
+                    object * o = var(bp, pc->m_x).m_obj;
+                    value v = var(bp, pc->m_y);
+                    lean_assert(is_exclusive(o));
+                    switch (pc->m_type) {
+                        case type::Float: cnstr_set_float(o, pc->m_i, v.m_float); break;
+                        case type::UInt8: cnstr_set_uint8(o, pc->m_i, v.m_num); break;
+                        case type::UInt16: cnstr_set_uint16(o, pc->m_i, v.m_num); break;
+                        case type::UInt32: cnstr_set_uint32(o, pc->m_i, v.m_num); break;
+                        case type::UInt64: cnstr_set_uint64(o, pc->m_i, v.m_num); break;
+                        default: lean_unreachable();
+                    }
+                    pc++;
+                    continue;
+                }
+                case opcode::Inc: // increment reference counter
+                    inc(var(bp, pc->m_x).m_obj, pc->m_i);
+                    pc++;
+                    continue;
+                case opcode::Dec: // decrement reference counter
+                    for (size_t i = 0; i < pc->m_i; i++) {
+                        dec(var(bp, pc->m_x).m_obj);
+                    }
+                    pc++;
+                    continue;
+                case opcode::Del: // delete object of unique reference
+                    lean_free_object(var(bp, pc->m_x).m_obj);
+                    pc++;
+                    continue;
+                case opcode::Case: { // branch according to constructor tag
+                    value v = var(bp, pc->m_x);
+                    unsigned tag = pc->m_flag ? v.m_num : lean_obj_tag(v.m_obj);
+                    uint32 target = tag < pc->m_num_args ? args[tag] : pc->m_i;
+                    if (target == g_no_target) {
+                        throw exception("incomplete case");
+                    }
+                    pc = instrs + target;
+                    continue;
+                }
+                case opcode::Ret:
+                    return eval_arg(bp, pc->m_y);
+                case opcode::Jmp: // jump to join-point, passing arguments in parameter slots
+                    for (size_t i = 0; i < pc->m_num_args; i++) {
+                        var(bp, args[2*i]) = eval_arg(bp, args[2*i + 1]);
+                    }
+                    pc = instrs + pc->m_i;
+                    continue;
+                case opcode::Unreachable:
                     throw exception("unreachable code");
+                case opcode::Invalid:
+                    throw exception("invalid instruction");
             }
+            // NOTE: `var` must be called *after* evaluating `r` because the stack may get resized and invalidate
+            // the reference
+            var(bp, pc->m_x) = r;
+            DEBUG_CODE(lean_trace(name({"interpreter", "step"}),
+                                  tout() << std::string(m_call_stack.size(), ' ') << "=> x_";
+                                  tout() << (pc->m_x + 1) << " = ";
+                                  print_value(tout(), r, pc->m_type);
+                                  tout() << "\n";);)
+            pc++;
         }
     }
 
-    // specify argument base pointer explicitly because we've usually already pushed some function arguments
-    void push_frame(decl const & d, size_t arg_bp) {
+    // specify argument base pointer explicitly because we've usually already pushed some function arguments; the stack
+    // is extended to `frame_size` slots above it
+    void push_frame(decl const & d, size_t arg_bp, size_t frame_size = 0) {
         DEBUG_CODE({
             lean_trace(name({"interpreter", "call"}),
                        tout() << std::string(m_call_stack.size(), ' ')
@@ -738,12 +1397,20 @@ private:
                        }
                        tout() << "\n";);
         });
-        m_call_stack.emplace_back(decl_fun_id(d), arg_bp, m_jp_stack.size());
+        m_call_stack.emplace_back(decl_fun_id(d), arg_bp);
+        if (arg_bp + frame_size > m_arg_stack.size()) {
+            m_arg_stack.resize(arg_bp + frame_size);
+        }
+        if (m_profile) {
+            m_profile->enter(decl_fun_id(d));
+        }
     }
 
     void pop_frame(value DEBUG_CODE(r), type DEBUG_CODE(t)) {
+        if (m_profile) {
+            m_profile->leave();
+        }
         m_arg_stack.resize(get_frame().m_arg_bp);
-        m_jp_stack.resize(get_frame().m_jp_bp);
         m_call_stack.pop_back();
         DEBUG_CODE({
             lean_trace(name({"interpreter", "call"}),
@@ -754,27 +1421,46 @@ private:
        });
     }
 
+    /** \brief Look up native code for `fn` in the current binary unless `lookup` is false and `fn` is not required to be
+        native. */
+    interpreter_cache::symbol_info resolve_symbol(name const & fn, decl const & d, bool lookup) {
+        interpreter_cache::symbol_info e { d, nullptr, false, decl_tag(d) == decl_kind::Extern || has_init_attribute(m_env, fn) };
+        if (lookup || e.m_force_native) {
+            string_ref mangled = name_mangle(fn, *g_mangle_prefix);
+            string_ref boxed_mangled(string_append(mangled.to_obj_arg(), g_boxed_mangled_suffix->raw()));
+            // check for boxed version first
+            if (void *p_boxed = lookup_symbol_in_cur_exe(boxed_mangled.data())) {
+                e.m_addr = p_boxed;
+                e.m_boxed = true;
+            } else if (void *p = lookup_symbol_in_cur_exe(mangled.data())) {
+                // if there is no boxed version, there are no unboxed parameters, so use default version
+                e.m_addr = p;
+            }
+        }
+        return e;
+    }
+
     /** \brief Return cached lookup result for given unmangled function name in the current binary. */
-    symbol_cache_entry lookup_symbol(name const & fn) {
-        if (symbol_cache_entry const * e = m_symbol_cache.find(fn)) {
-            return *e;
-        } else {
-            symbol_cache_entry e_new { get_decl(fn), nullptr, false };
-            if (m_prefer_native || decl_tag(e_new.m_decl) == decl_kind::Extern || has_init_attribute(m_env, fn)) {
-                string_ref mangled = name_mangle(fn, *g_mangle_prefix);
-                string_ref boxed_mangled(string_append(mangled.to_obj_arg(), g_boxed_mangled_suffix->raw()));
-                // check for boxed version first
-                if (void *p_boxed = lookup_symbol_in_cur_exe(boxed_mangled.data())) {
-                    e_new.m_addr = p_boxed;
-                    e_new.m_boxed = true;
-                } else if (void *p = lookup_symbol_in_cur_exe(mangled.data())) {
-                    // if there is no boxed version, there are no unboxed parameters, so use default version
-                    e_new.m_addr = p;
-                }
+    symbol_cache_entry & lookup_symbol(name const & fn) {
+        auto it = m_symbol_cache.find(fn);
+        if (it != m_symbol_cache.end()) {
+            return it->second;
+        }
+        interpreter_cache::symbol_entry * shared = m_cache ? m_cache->find_symbol(fn) : nullptr;
+        optional<interpreter_cache::symbol_info> local;
+        if (!shared) {
+            option_ref<decl> d = m_cache ? find_imported_ir_decl(m_env, fn) : option_ref<decl>();
+            if (d) {
+                // always look up native code so that the entry can be shared regardless of `m_prefer_native`
+                shared = m_cache->insert_symbol(fn, resolve_symbol(fn, *d.get(), true));
+            } else {
+                local = resolve_symbol(fn, get_decl(fn), m_prefer_native);
             }
-            m_symbol_cache.insert(fn, e_new);
-            return e_new;
         }
+        interpreter_cache::symbol_info const & s = shared ? shared->m_info : *local;
+        bool native = m_prefer_native || s.m_force_native;
+        symbol_cache_entry e_new { s.m_decl, native ? s.m_addr : nullptr, native && s.m_boxed, shared, nullptr };
+        return m_symbol_cache.emplace(fn, std::move(e_new)).first->second;
     }
 
     /** \brief Retrieve Lean declaration from environment. */
@@ -788,18 +1474,19 @@ private:
 
     /** \brief Evaluate nullary function ("constant"). */
     value load(name const & fn, type t) {
-        if (constant_cache_entry const * cached = m_constant_cache.find(fn)) {
-            if (!cached->m_is_scalar) {
-                inc(cached->m_val.m_obj);
+        auto it = m_constant_cache.find(fn);
+        if (it != m_constant_cache.end()) {
+            if (!it->second.m_is_scalar) {
+                inc(it->second.m_val.m_obj);
             }
-            return cached->m_val;
+            return it->second.m_val;
         }
         if (object * const * o = g_init_globals->find(fn)) {
             // persistent, so no `inc` needed
             return type_is_scalar(t) ? unbox_t(*o, t) : *o;
         }
 
-        symbol_cache_entry e = lookup_symbol(fn);
+        symbol_cache_entry & e = lookup_symbol(fn);
         if (e.m_addr) {
             // we can assume that all native code has been initialized (see e.g. `evalConst`)
 
@@ -818,30 +1505,165 @@ private:
             }
         }
 
+        if (e.m_shared) {
+            if (optional<constant_cache_entry> cached = m_cache->find_constant(fn)) {
+                // we now own one reference, add one for the local cache
+                if (!cached->m_is_scalar) {
+                    inc(cached->m_val.m_obj);
+                }
+                m_constant_cache.emplace(fn, *cached);
+                return cached->m_val;
+            }
+        }
+
         // no native code, so might be part of the current module
         if (get_regular_init_fn_name_for(m_env, fn)) {
             // We don't know whether `[init]` decls can be re-executed, so let's not.
             throw exception(sstream() << "cannot evaluate `[init]` declaration '" << fn << "' in the same module");
         }
-        push_frame(e.m_decl, m_arg_stack.size());
-        value r = eval_body(decl_fun_body(e.m_decl));
+        code const & c = get_code(e);
+        push_frame(e.m_decl, m_arg_stack.size(), c.m_frame_size);
+        value r = eval_body(c);
         pop_frame(r, decl_type(e.m_decl));
         if (!type_is_scalar(t)) {
             inc(r.m_obj);
         }
-        m_constant_cache.insert(fn, constant_cache_entry { type_is_scalar(t), r });
+        constant_cache_entry entry { type_is_scalar(t), r };
+        m_constant_cache.emplace(fn, entry);
+        if (e.m_shared) {
+            m_cache->insert_constant(fn, entry);
+        }
         return r;
     }
 
-    value call(name const & fn, array_ref<arg> const & args) {
+    /** \brief Add `fn` and the declarations without native code it uses to `decls` for compiling them with `jit`, in
+        post-order so that constants are initialized after the constants they depend on. Returns false if some
+        declaration cannot be compiled. */
+    bool collect_jit_decls(name const & fn, name_set & visited, buffer<name> & decls) {
+        if (visited.contains(fn)) {
+            return true;
+        }
+        visited.insert(fn);
+        symbol_cache_entry & e = lookup_symbol(fn);
+        if (!e.m_shared) {
+            // a declaration of the current module, which may differ between environments sharing `m_cache`
+            return false;
+        }
+        interpreter_cache::symbol_info const & s = e.m_shared->m_info;
+        if (s.m_addr) {
+            // provided by the current process
+            return true;
+        }
+        if (s.m_force_native || decls.size() >= g_jit_max_decls) {
+            return false;
+        }
+        for (instr const & i : get_code(e).m_instrs) {
+            switch (i.m_op) {
+                case opcode::Call: case opcode::Load: case opcode::PAp:
+                    // `TailCall` is only used for calls of `fn` itself and does not store its target
+                    if (!collect_jit_decls(TO_REF(name, i.m_obj), visited, decls)) {
+                        return false;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        decls.push_back(fn);
+        return true;
+    }
+
+    template<class T> static void init_jit_constant(jit_symbol const & s) {
+        *static_cast<T *>(s.m_global) = reinterpret_cast<T (*)()>(s.m_code)();
+    }
+
+    /** \brief Compile the imported function `e` to native code, returning its boxed entry point if it has a boxed
+        version, or `nullptr` on failure. */
+    void * jit(symbol_cache_entry & e, bool & boxed) {
+        name const & fn = decl_fun_id(e.m_decl);
+        name boxed_fn(fn, g_boxed_suffix->data());
+        boxed = static_cast<bool>(find_imported_ir_decl(m_env, boxed_fn));
+        buffer<name> decls;
+        name_set visited;
+        if (!collect_jit_decls(fn, visited, decls) || (boxed && !collect_jit_decls(boxed_fn, visited, decls))) {
+            return nullptr;
+        }
+        std::vector<jit_symbol> syms;
+        try {
+            syms = jit_compile(m_env, decls);
+        } catch (exception & ex) {
+            DEBUG_CODE(lean_trace(name({"interpreter", "jit"}), tout() << "failed to compile '" << fn << "': " << ex.what() << "\n";););
+            return nullptr;
+        }
+        void * entry = nullptr;
+        for (size_t i = 0; i < decls.size(); i++) {
+            if (decls[i] == (boxed ? boxed_fn : fn)) {
+                entry = syms[i].m_code;
+            }
+            if (!syms[i].m_global) {
+                continue;
+            }
+            // initialize constants like a module initializer would
+            switch (decl_type(lookup_symbol(decls[i]).m_decl)) {
+                case type::Float: init_jit_constant<double>(syms[i]); break;
+                case type::UInt8: init_jit_constant<uint8>(syms[i]); break;
+                case type::UInt16: init_jit_constant<uint16>(syms[i]); break;
+                case type::UInt32: init_jit_constant<uint32>(syms[i]); break;
+                case type::UInt64: init_jit_constant<uint64>(syms[i]); break;
+                case type::USize: init_jit_constant<size_t>(syms[i]); break;
+                case type::Object:
+                case type::TObject:
+                case type::Irrelevant:
+                    init_jit_constant<object *>(syms[i]);
+                    mark_persistent(*static_cast<object **>(syms[i].m_global));
+                    break;
+            }
+        }
+        return entry;
+    }
+
+    /** \brief Return true if `e` is an imported function without native code that `check_jit` should consider. */
+    bool is_jit_candidate(symbol_cache_entry const & e) const {
+        return !e.m_addr && m_jit_threshold && e.m_shared && !e.m_shared->m_info.m_addr &&
+            decl_tag(e.m_decl) == decl_kind::Fun;
+    }
+
+    /** \brief Count an interpreted call of the imported function `e` and switch `e` to compiled code once available,
+        compiling it when the number of calls reaches `interpreter.jit_threshold`. Compilation is attempted at most once
+        per function and environment import. */
+    void check_jit(symbol_cache_entry & e) {
+        interpreter_cache::symbol_entry & s = *e.m_shared;
+        void * addr = s.m_jit_addr.load(std::memory_order_acquire);
+        if (!addr) {
+            if (s.m_jit_started.load(std::memory_order_relaxed) ||
+                s.m_calls.fetch_add(1, std::memory_order_relaxed) + 1 < m_jit_threshold ||
+                s.m_jit_started.exchange(true)) {
+                return;
+            }
+            bool boxed;
+            addr = jit(e, boxed);
+            if (!addr) {
+                return;
+            }
+            s.m_jit_boxed = boxed;
+            s.m_jit_addr.store(addr, std::memory_order_release);
+        }
+        e.m_addr = addr;
+        e.m_boxed = s.m_jit_boxed;
+    }
+
+    /** \brief Call `e` with the arguments in slots `args` of the frame starting at `bp`. */
+    value call(symbol_cache_entry & e, uint32 const * args, size_t n, size_t bp) {
         size_t old_size = m_arg_stack.size();
         value r;
-        symbol_cache_entry e = lookup_symbol(fn);
+        if (is_jit_candidate(e)) {
+            check_jit(e);
+        }
         if (e.m_addr) {
-            object ** args2 = static_cast<object **>(LEAN_ALLOCA(args.size() * sizeof(object *))); // NOLINT
-            for (size_t i = 0; i < args.size(); i++) {
+            object ** args2 = static_cast<object **>(LEAN_ALLOCA(n * sizeof(object *))); // NOLINT
+            for (size_t i = 0; i < n; i++) {
                 type t = param_type(decl_params(e.m_decl)[i]);
-                args2[i] = box_t(eval_arg(args[i]), t);
+                args2[i] = box_t(eval_arg(bp, args[i]), t);
                 if (e.m_boxed && param_borrow(decl_params(e.m_decl)[i])) {
                     // NOTE: If we chose the boxed version where the IR chose the unboxed one, we need to manually increment
                     // originally borrowed parameters because the wrapper will decrement these after the call.
@@ -851,7 +1673,7 @@ private:
                 }
             }
             push_frame(e.m_decl, old_size);
-            object * o = curry(e.m_addr, args.size(), args2);
+            object * o = curry(e.m_addr, n, args2);
             type t = decl_type(e.m_decl);
             if (type_is_scalar(t)) {
                 lean_assert(e.m_boxed);
@@ -863,6 +1685,7 @@ private:
             }
         } else {
             if (decl_tag(e.m_decl) == decl_kind::Extern) {
+                name const & fn = decl_fun_id(e.m_decl);
                 string_ref mangled = name_mangle(fn, *g_mangle_prefix);
                 string_ref boxed_mangled(string_append(mangled.to_obj_arg(), g_boxed_mangled_suffix->raw()));
                 throw exception(sstream() << "Could not find native implementation of external declaration '" << fn
@@ -870,12 +1693,13 @@ private:
                                           << "For declarations from `Init`, `Std`, or `Lean`, you need to set `supportInterpreter := true` "
                                           << "in the relevant `lean_exe` statement in your `lakefile.lean`.");
             }
+            code const & c = get_code(e);
             // evaluate args in old stack frame
-            for (const auto & arg : args) {
-                m_arg_stack.push_back(eval_arg(arg));
+            for (size_t i = 0; i < n; i++) {
+                m_arg_stack.push_back(eval_arg(bp, args[i]));
             }
-            push_frame(e.m_decl, old_size);
-            r = eval_body(decl_fun_body(e.m_decl));
+            push_frame(e.m_decl, old_size, c.m_frame_size);
+            r = eval_body(c);
         }
         pop_frame(r, decl_type(e.m_decl));
         return r;
@@ -884,12 +1708,25 @@ private:
     // closure stub
     object * stub_m(object ** args) {
         decl d(args[2]);
+        symbol_cache_entry & e = lookup_symbol(decl_fun_id(d));
+        if (is_jit_candidate(e)) {
+            check_jit(e);
+            if (e.m_addr) {
+                // `d` takes boxed, owned arguments only, so it is its own boxed version
+                lean_assert(!e.m_boxed);
+                push_frame(d, m_arg_stack.size());
+                object * r = curry(e.m_addr, decl_params(d).size(), args + 3);
+                pop_frame(r, type::TObject);
+                return r;
+            }
+        }
+        code const & c = get_code(e);
         size_t old_size = m_arg_stack.size();
         for (size_t i = 0; i < decl_params(d).size(); i++) {
             m_arg_stack.push_back(args[3 + i]);
         }
-        push_frame(d, old_size);
-        object * r = eval_body(decl_fun_body(d)).m_obj;
+        push_frame(d, old_size, c.m_frame_size);
+        object * r = eval_body(c).m_obj;
         pop_frame(r, type::TObject);
         return r;
     }
@@ -946,16 +1783,27 @@ private:
 public:
     explicit interpreter(environment const & env, options const & opts) : m_env(env), m_opts(opts) {
         m_prefer_native = opts.get_bool(*g_interpreter_prefer_native, LEAN_DEFAULT_INTERPRETER_PREFER_NATIVE);
+        m_jit_threshold = jit_available() ? opts.get_unsigned(*g_interpreter_jit_threshold, LEAN_DEFAULT_INTERPRETER_JIT_THRESHOLD) : 0;
+        char const * profile = opts.get_string(*g_interpreter_profile, "");
+        m_profile = *profile ? get_thread_profile(profile) : nullptr;
+        m_profile_depth = m_profile ? m_profile->depth() : 0;
+        m_cache = get_interpreter_cache(env);
     }
 
     interpreter(interpreter const &) = delete;
 
     ~interpreter() {
-        for_each(m_constant_cache, [](name const &, constant_cache_entry const & e) {
-            if (!e.m_is_scalar) {
-                dec(e.m_val.m_obj);
+        if (m_profile) {
+            // close frames left by an exception
+            while (m_profile->depth() > m_profile_depth) {
+                m_profile->leave();
             }
-        });
+        }
+        for (auto const & p : m_constant_cache) {
+            if (!p.second.m_is_scalar) {
+                dec(p.second.m_val.m_obj);
+            }
+        }
     }
 
     /** A variant of `call` designed for external uses.
@@ -963,7 +1811,7 @@ public:
      *  * supports under- and over-application.
      *  * supports "calling" (evaluating) nullary constants. */
     object * call_boxed(name const & fn, unsigned n, object ** args) {
-        symbol_cache_entry e = lookup_symbol(fn);
+        symbol_cache_entry & e = lookup_symbol(fn);
         unsigned arity = decl_params(e.m_decl).size();
         object * r;
         if (arity == 0) {
@@ -1037,7 +1885,7 @@ public:
                 object * o = io_result_get_value(r);
                 mark_persistent(o);
                 dec_ref(r);
-                symbol_cache_entry e = lookup_symbol(decl);
+                symbol_cache_entry & e = lookup_symbol(decl);
                 if (e.m_addr) {
                     *((object **)e.m_addr) = o;
                 } else {
@@ -1113,17 +1961,36 @@ void initialize_ir_interpreter() {
     ir::g_boxed_mangled_suffix = new string_ref("___boxed");
     mark_persistent(ir::g_boxed_mangled_suffix->raw());
     ir::g_interpreter_prefer_native = new name({"interpreter", "prefer_native"});
+    ir::g_interpreter_jit_threshold = new name({"interpreter", "jit_threshold"});
+    ir::g_interpreter_profile = new name({"interpreter", "profile"});
+    ir::g_profiles_mutex = new mutex();
+    ir::g_profiles = new std::vector<ir::call_profile *>();
+    ir::g_profile_file = new std::string();
     ir::g_init_globals = new name_map<object *>();
+    ir::g_interpreter_cache_external_class = lean_register_external_class(ir::interpreter_cache_finalizer, ir::interpreter_cache_foreach);
     register_bool_option(*ir::g_interpreter_prefer_native, LEAN_DEFAULT_INTERPRETER_PREFER_NATIVE, "(interpreter) whether to use precompiled code where available");
+    register_unsigned_option(*ir::g_interpreter_jit_threshold, LEAN_DEFAULT_INTERPRETER_JIT_THRESHOLD,
+                             "(interpreter) number of calls after which imported functions without precompiled code are compiled to native code, if supported (0 = never)");
+    register_option(*ir::g_interpreter_profile, {}, data_value_kind::String, "",
+                    "(interpreter) if set, write self times (in microseconds) and allocations of interpreted functions and their native callees per call path in the collapsed stack format of flame graph tools to this file and to this file with suffix '.alloc', respectively, at exit");
     DEBUG_CODE({
         register_trace_class({"interpreter"});
         register_trace_class({"interpreter", "call"});
+        register_trace_class({"interpreter", "jit"});
         register_trace_class({"interpreter", "step"});
     });
 }
 
 void finalize_ir_interpreter() {
     delete ir::g_init_globals;
+    for (ir::call_profile * p : *ir::g_profiles) {
+        delete p;
+    }
+    delete ir::g_profile_file;
+    delete ir::g_profiles;
+    delete ir::g_profiles_mutex;
+    delete ir::g_interpreter_profile;
+    delete ir::g_interpreter_jit_threshold;
     delete ir::g_interpreter_prefer_native;
     delete ir::g_boxed_mangled_suffix;
     delete ir::g_boxed_suffix;
@@ -13,6 +13,8 @@ namespace ir {
 /** \brief Run `n` using the "boxed" ABI, i.e. with all-owned parameters. */
 object * run_boxed(environment const & env, options const & opts, name const & fn, unsigned n, object **args);
 uint32 run_main(environment const & env, options const & opts, int argv, char * argc[]);
+/** \brief Write the profile collected by interpreters with `interpreter.profile` set, if any. */
+void save_interpreter_profile();
 }
 void initialize_ir_interpreter();
 void finalize_ir_interpreter();
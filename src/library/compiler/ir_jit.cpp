@@ -0,0 +1,174 @@
+/*
+Copyright (c) 2024 Lean FRO, LLC. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+JIT tier of the IR interpreter: hot interpreted functions are translated to LLVM IR by `Lean.IR.emitLLVMJIT` and
+compiled in-process by ORC's LLJIT. Without LLVM support, `jit_compile` always fails and the interpreter keeps
+interpreting such functions.
+*/
+#include <string>
+#include <vector>
+#include "runtime/thread.h"
+#include "runtime/sstream.h"
+#include "runtime/pair_ref.h"
+#include "runtime/array_ref.h"
+#include "runtime/string_ref.h"
+#include "util/io.h"
+#include "library/compiler/ir_jit.h"
+
+#ifdef LEAN_LLVM
+#include "llvm-c/Core.h"
+#include "llvm-c/Error.h"
+#include "llvm-c/LLJIT.h"
+#include "llvm-c/Orc.h"
+#include "llvm-c/Target.h"
+#include "llvm-c/TargetMachine.h"
+#include "llvm-c/Transforms/PassBuilder.h"
+#endif
+
+namespace lean {
+namespace ir {
+#ifdef LEAN_LLVM
+extern "C" object * lean_ir_emit_llvm_jit(object * env, size_t ctx, object * decls, object * w);
+
+static mutex * g_jit_mutex = nullptr;
+// created on first use, protected by `g_jit_mutex`
+static LLVMOrcLLJITRef g_jit = nullptr;
+static LLVMTargetMachineRef g_jit_target_machine = nullptr;
+// used for making the symbols of each `jit_compile` call unique
+static unsigned g_jit_next_id = 0;
+
+static void check_llvm_error(char const * what, LLVMErrorRef err) {
+    if (err) {
+        char * msg = LLVMGetErrorMessage(err);
+        std::string s(msg);
+        LLVMDisposeErrorMessage(msg);
+        throw exception(sstream() << what << ": " << s);
+    }
+}
+
+static void init_jit() {
+    if (g_jit)
+        return;
+    LLVMInitializeNativeTarget();
+    LLVMInitializeNativeAsmPrinter();
+    LLVMOrcLLJITRef jit;
+    check_llvm_error("failed to create JIT", LLVMOrcCreateLLJIT(&jit, LLVMOrcCreateLLJITBuilder()));
+    // resolve references to the runtime and to precompiled code against the current process
+    LLVMOrcDefinitionGeneratorRef gen;
+    check_llvm_error("failed to create JIT",
+                     LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(&gen, LLVMOrcLLJITGetGlobalPrefix(jit), nullptr, nullptr));
+    LLVMOrcJITDylibAddGenerator(LLVMOrcLLJITGetMainJITDylib(jit), gen);
+    // target machine for running the optimization pipeline before handing modules to the JIT
+    char const * triple = LLVMOrcLLJITGetTripleString(jit);
+    LLVMTargetRef target;
+    char * err;
+    if (LLVMGetTargetFromTriple(triple, &target, &err)) {
+        std::string s(err);
+        LLVMDisposeMessage(err);
+        throw exception(sstream() << "failed to create JIT: " << s);
+    }
+    char * cpu = LLVMGetHostCPUName();
+    char * features = LLVMGetHostCPUFeatures();
+    g_jit_target_machine = LLVMCreateTargetMachine(target, triple, cpu, features, LLVMCodeGenLevelDefault,
+                                                   LLVMRelocDefault, LLVMCodeModelJITDefault);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(features);
+    g_jit = jit;
+}
+
+bool jit_available() {
+    return true;
+}
+
+std::vector<jit_symbol> jit_compile(environment const & env, buffer<name> const & decls) {
+    lock_guard<mutex> _(*g_jit_mutex);
+    init_jit();
+    LLVMOrcThreadSafeContextRef tsc = LLVMOrcCreateNewThreadSafeContext();
+    LLVMModuleRef mod;
+    array_ref<pair_ref<string_ref, string_ref>> syms;
+    try {
+        LLVMContextRef ctx = LLVMOrcThreadSafeContextGetContext(tsc);
+        auto r = get_io_result<pair_ref<object_ref, array_ref<pair_ref<string_ref, string_ref>>>>(lean_ir_emit_llvm_jit(
+            env.to_obj_arg(), reinterpret_cast<size_t>(ctx), array_ref<name>(decls).steal(), io_mk_world()));
+        mod = reinterpret_cast<LLVMModuleRef>(lean_unbox_usize(r.fst().raw()));
+        syms = r.snd();
+    } catch (...) {
+        LLVMOrcDisposeThreadSafeContext(tsc);
+        throw;
+    }
+    // Symbols of the current process take precedence over JIT-defined ones, and code for the same declaration may be
+    // compiled repeatedly for different environments, so make our definitions unique.
+    std::string prefix = (sstream() << "_lean_jit_" << g_jit_next_id++ << "_").str();
+    auto rename = [&](LLVMValueRef v, char const * sym) {
+        if (!v) {
+            LLVMDisposeModule(mod);
+            LLVMOrcDisposeThreadSafeContext(tsc);
+            throw exception(sstream() << "JIT module does not define '" << sym << "'");
+        }
+        std::string n = prefix + LLVMGetValueName(v);
+        LLVMSetValueName2(v, n.data(), n.size());
+        // initializers and closed terms are emitted as hidden, which would hide them from the lookup below
+        LLVMSetVisibility(v, LLVMDefaultVisibility);
+        return n;
+    };
+    std::vector<std::pair<std::string, std::string>> names;
+    for (pair_ref<string_ref, string_ref> const & s : syms) {
+        std::string code = rename(LLVMGetNamedFunction(mod, s.fst().data()), s.fst().data());
+        std::string global = s.snd().num_bytes() > 0 ? rename(LLVMGetNamedGlobal(mod, s.snd().data()), s.snd().data()) : std::string();
+        names.emplace_back(code, global);
+    }
+    LLVMPassBuilderOptionsRef opts = LLVMCreatePassBuilderOptions();
+    LLVMErrorRef err = LLVMRunPasses(mod, "default<O2>", g_jit_target_machine, opts);
+    LLVMDisposePassBuilderOptions(opts);
+    if (err) {
+        LLVMDisposeModule(mod);
+        LLVMOrcDisposeThreadSafeContext(tsc);
+        check_llvm_error("failed to optimize JIT module", err);
+    }
+    // the module now owns the context
+    LLVMOrcThreadSafeModuleRef tsm = LLVMOrcCreateNewThreadSafeModule(mod, tsc);
+    LLVMOrcDisposeThreadSafeContext(tsc);
+    err = LLVMOrcLLJITAddLLVMIRModule(g_jit, LLVMOrcLLJITGetMainJITDylib(g_jit), tsm);
+    if (err) {
+        LLVMOrcDisposeThreadSafeModule(tsm);
+        check_llvm_error("failed to add JIT module", err);
+    }
+    auto lookup = [&](std::string const & n) {
+        LLVMOrcExecutorAddress addr;
+        check_llvm_error("failed to compile JIT module", LLVMOrcLLJITLookup(g_jit, &addr, n.c_str()));
+        return reinterpret_cast<void *>(addr);
+    };
+    std::vector<jit_symbol> r;
+    for (auto const & n : names) {
+        r.push_back(jit_symbol { lookup(n.first), n.second.empty() ? nullptr : lookup(n.second) });
+    }
+    return r;
+}
+#else
+bool jit_available() {
+    return false;
+}
+
+std::vector<jit_symbol> jit_compile(environment const &, buffer<name> const &) {
+    throw exception("JIT compilation requires LLVM support");
+}
+#endif
+}
+
+void initialize_ir_jit() {
+#ifdef LEAN_LLVM
+    ir::g_jit_mutex = new mutex();
+#endif
+}
+
+void finalize_ir_jit() {
+#ifdef LEAN_LLVM
+    if (ir::g_jit) {
+        LLVMOrcDisposeLLJIT(ir::g_jit);
+        LLVMDisposeTargetMachine(ir::g_jit_target_machine);
+    }
+    delete ir::g_jit_mutex;
+#endif
+}
+}
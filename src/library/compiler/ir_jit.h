@@ -0,0 +1,29 @@
+/*
+Copyright (c) 2024 Lean FRO, LLC. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+*/
+#pragma once
+#include <vector>
+#include "kernel/environment.h"
+
+namespace lean {
+namespace ir {
+/** \brief Return true iff IR can be compiled to native code at run time, which requires LLVM support. */
+bool jit_available();
+
+struct jit_symbol {
+    // entry point of a function, or initializer of a constant
+    void * m_code;
+    // global storing the value of a constant, `nullptr` for functions
+    void * m_global;
+};
+
+/** \brief Compile the IR declarations `decls` of `env` to native code in the current process. Other declarations used
+    by `decls` must have native code in the current process. The global of each constant in `decls` must be set to the
+    (persistent) result of its initializer before any code referring to it is run. Compiled code is never freed. Throws
+    an exception on failure. */
+std::vector<jit_symbol> jit_compile(environment const & env, buffer<name> const & decls);
+}
+void initialize_ir_jit();
+void finalize_ir_jit();
+}
@@ -13,15 +13,18 @@ Author: Leonardo de Moura
 #include "library/profiling.h"
 #include "library/time_task.h"
 #include "library/formatter.h"
+#include "library/module.h"
 
 namespace lean {
 void initialize_library_core_module() {
     initialize_formatter();
     initialize_constants();
     initialize_profiling();
+    initialize_module();
 }
 
 void finalize_library_core_module() {
+    finalize_module();
     finalize_profiling();
     finalize_constants();
     finalize_formatter();
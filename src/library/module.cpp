@@ -43,13 +43,20 @@ Authors: Leonardo de Moura, Gabriel Ebner, Sebastian Ullrich
 #endif
 #endif
 
+#ifdef LEAN_USE_ZSTD
+#include <zstd.h>
+#endif
+
+// uncompressed size of the independently compressed blocks of a compressed .olean file
+#define LEAN_OLEAN_BLOCK_SIZE (1024*1024)
+
 namespace lean {
 
 /** On-disk format of a .olean file. */
 struct olean_header {
     // 5 bytes: magic number
     char marker[5] = {'o', 'l', 'e', 'a', 'n'};
-    // 1 byte: version, currently always `1`
+    // 1 byte: version, `1`, or `2` if the header is followed by an `olean_header_ext`
     uint8_t version = 1;
     // 42 bytes: build githash, padded with `\0` to the right
     char githash[42];
@@ -61,17 +68,272 @@ struct olean_header {
 // make sure we don't have any padding bytes, which also ensures `data` is properly aligned
 static_assert(sizeof(olean_header) == 5 + 1 + 42 + sizeof(size_t), "olean_header must be packed");
 
-extern "C" LEAN_EXPORT object * lean_save_module_data(b_obj_arg fname, b_obj_arg mod, b_obj_arg mdata, object *) {
-    std::string olean_fn(string_cstr(fname));
+/** Header extension of a .olean file with `version == 2`, stored between `olean_header` and the payload. Version 2 is
+    only written when using features not supported by version 1, so that other files stay readable by older versions. */
+struct olean_header_ext {
+    // `base_addr` of the shared object dictionary referenced by the payload, or `0` if none; see `LEAN_OLEAN_DICTIONARY`
+    size_t dict_base_addr = 0;
+    // hash of the payload of the shared object dictionary, used to reject incompatible dictionaries
+    uint64 dict_hash = 0;
+    // number of zstd-compressed blocks the payload is split into, or `0` if it is stored uncompressed; see
+    // `LEAN_OLEAN_COMPRESS`. A compressed payload is stored as the `uint64` end offsets of all compressed blocks,
+    // followed by the blocks, each of which decompresses to `LEAN_OLEAN_BLOCK_SIZE` bytes except for the last one.
+    size_t num_blocks = 0;
+    // size of the uncompressed payload if `num_blocks != 0`
+    size_t payload_size = 0;
+};
+static_assert(sizeof(olean_header_ext) == 3 * sizeof(size_t) + sizeof(uint64), "olean_header_ext must be packed");
+
+static size_t olean_payload_offset(olean_header const & header) {
+    return sizeof(olean_header) + (header.version >= 2 ? sizeof(olean_header_ext) : 0);
+}
+
+/*
+  Shared object dictionary.
+
+  If the environment variable `LEAN_OLEAN_DICTIONARY` is set to the path of a file in .olean format (see
+  `lean_save_olean_dictionary` and `script/mkOleanDictionary.lean`), .olean files written by this process reference
+  objects of the dictionary instead of storing their own copies of them (see `object_compactor::set_dictionary`).
+  Common `Name`, `Level`, and `Expr` objects are thus stored and, when importing, loaded only once per build instead of
+  once per module. Reading such a .olean file requires the variable to point to the same dictionary. The dictionary is
+  loaded on first use and never freed, once for reading and once, together with its index, for writing. */
+static char const * g_olean_dictionary_var = "LEAN_OLEAN_DICTIONARY";
+static mutex * g_olean_dictionary_mutex = nullptr;
+static compacted_region * g_olean_dictionary = nullptr;
+static size_t g_olean_dictionary_base_addr = 0;
+static uint64 g_olean_dictionary_hash = 0;
+
+/* The dictionary as used for writing .olean files: its unrelocated payload and the index of its objects. */
+struct olean_dictionary_writer {
+    std::string m_data;
+    size_t      m_base_addr;
+    uint64      m_hash;
+    std::shared_ptr<object_compactor::dictionary const> m_index;
+};
+static olean_dictionary_writer * g_olean_dictionary_writer = nullptr;
+
+static uint64 hash_olean_payload(size_t size, char const * data) {
+    return hash_str(size, reinterpret_cast<unsigned char const *>(data), 11);
+}
+
+static size_t olean_base_addr(size_t h) {
+    // x86-64 user space is currently limited to the lower 47 bits
+    // https://en.wikipedia.org/wiki/X86-64#Virtual_address_space_details
+    // On Linux at least, the stack grows down from ~0x7fff... followed by shared libraries, so reserve
+    // a bit of space for them (0x7fff...-0x7f00... = 1TB)
+    size_t base_addr = h % 0x7f0000000000;
+    // `mmap` addresses must be page-aligned. The default (non-huge) page size on x86-64 is 4KB.
+    // `MapViewOfFileEx` addresses must be aligned to the "memory allocation granularity", which is 64KB.
+    return base_addr & ~((1LL<<16) - 1);
+}
+
+/*
+  Compressed .olean files.
+
+  If the environment variable `LEAN_OLEAN_COMPRESS` is set to a zstd compression level, .olean files written by this
+  process are compressed in blocks, which are decompressed in parallel when reading them. This trades `mmap`ing the
+  file for smaller files, which pays off when .olean files are transferred or read from a cold cache. Where possible,
+  the payload is decompressed into memory at its base address so that it still does not need to be relocated. */
+static char const * g_olean_compress_var = "LEAN_OLEAN_COMPRESS";
+
+#ifdef LEAN_USE_ZSTD
+/* Runs `fn(i)` for all `i < n`, distributing the calls over up to `hardware_concurrency()` threads. */
+static void parallel_for(size_t n, std::function<void(size_t)> const & fn) {
+#if defined(LEAN_MULTI_THREAD)
+    size_t num_threads = std::min<size_t>(n, std::max(1u, hardware_concurrency()));
+#else
+    size_t num_threads = 1;
+#endif
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = atomic_fetch_add_explicit(&next, static_cast<size_t>(1), memory_order_relaxed)) < n)
+            fn(i);
+    };
+    std::vector<std::unique_ptr<lthread>> threads;
+    for (size_t i = 1; i < num_threads; i++)
+        threads.emplace_back(new lthread(worker));
+    worker();
+    for (auto & t : threads)
+        t->join();
+}
+
+static size_t olean_num_blocks(size_t payload_size) {
+    return (payload_size + LEAN_OLEAN_BLOCK_SIZE - 1) / LEAN_OLEAN_BLOCK_SIZE;
+}
+
+static size_t olean_block_size(size_t payload_size, size_t i) {
+    return std::min<size_t>(LEAN_OLEAN_BLOCK_SIZE, payload_size - i * LEAN_OLEAN_BLOCK_SIZE);
+}
+
+/* Compresses `[data, data+size)`, writing the block end offsets and the compressed blocks to `out`. */
+static void compress_olean_payload(char const * data, size_t size, int level, olean_header_ext & header_ext, std::string & out) {
+    size_t num_blocks = olean_num_blocks(size);
+    std::vector<std::string> blocks(num_blocks);
+    atomic<bool> failed(false);
+    parallel_for(num_blocks, [&](size_t i) {
+        size_t block_size = olean_block_size(size, i);
+        std::string & block = blocks[i];
+        block.resize(ZSTD_compressBound(block_size));
+        // include checksums so that corrupted files are rejected instead of producing corrupted objects
+        ZSTD_CCtx * cctx = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+        size_t r = ZSTD_compress2(cctx, &block[0], block.size(), data + i * LEAN_OLEAN_BLOCK_SIZE, block_size);
+        ZSTD_freeCCtx(cctx);
+        if (ZSTD_isError(r))
+            failed = true;
+        else
+            block.resize(r);
+    });
+    if (failed)
+        throw exception("failed to compress .olean payload");
+    std::vector<uint64> block_ends;
+    uint64 end = 0;
+    for (std::string const & block : blocks) {
+        end += block.size();
+        block_ends.push_back(end);
+    }
+    out.append(reinterpret_cast<char const *>(block_ends.data()), sizeof(uint64) * num_blocks);
+    for (std::string const & block : blocks)
+        out.append(block);
+    header_ext.num_blocks   = num_blocks;
+    header_ext.payload_size = size;
+}
+
+/* Decompresses the payload stored in `[data, data+size)` into `buffer`. */
+static bool decompress_olean_payload(char const * data, size_t size, olean_header_ext const & header_ext, char * buffer) {
+    size_t num_blocks = header_ext.num_blocks;
+    size_t index_size = sizeof(uint64) * num_blocks;
+    if (size < index_size)
+        return false;
+    uint64 const * block_ends = reinterpret_cast<uint64 const *>(data);
+    char const * blocks = data + index_size;
+    size_t blocks_size  = size - index_size;
+    atomic<bool> failed(olean_num_blocks(header_ext.payload_size) != num_blocks);
+    parallel_for(failed ? 0 : num_blocks, [&](size_t i) {
+        uint64 begin = i == 0 ? 0 : block_ends[i - 1];
+        uint64 end   = block_ends[i];
+        size_t block_size = olean_block_size(header_ext.payload_size, i);
+        if (begin > end || end > blocks_size ||
+            ZSTD_decompress(buffer + i * LEAN_OLEAN_BLOCK_SIZE, block_size, blocks + begin, end - begin) != block_size)
+            failed = true;
+    });
+    return !failed;
+}
+#endif
+
+/* Returns the dictionary named by `LEAN_OLEAN_DICTIONARY` for writing .olean files, loading and indexing it on first use. */
+static olean_dictionary_writer const & get_olean_dictionary_writer(char const * dict_fn) {
+    lock_guard<mutex> lock(*g_olean_dictionary_mutex);
+    if (!g_olean_dictionary_writer) {
+        std::ifstream dict_in(dict_fn, std::ios_base::binary);
+        olean_header default_header = {};
+        olean_header dict_header;
+        // dictionaries must be version 1 files, see `get_olean_dictionary`
+        if (!dict_in.read(reinterpret_cast<char *>(&dict_header), sizeof(dict_header))
+            || memcmp(dict_header.marker, default_header.marker, sizeof(default_header.marker)) != 0
+            || dict_header.version != 1) {
+            throw exception(sstream() << "failed to read object dictionary '" << dict_fn << "', invalid header");
+        }
+        std::unique_ptr<olean_dictionary_writer> dict(new olean_dictionary_writer());
+        dict->m_data.assign(std::istreambuf_iterator<char>(dict_in), std::istreambuf_iterator<char>());
+        dict->m_base_addr = dict_header.base_addr;
+        dict->m_hash      = hash_olean_payload(dict->m_data.size(), dict->m_data.data());
+        dict->m_index     = object_compactor::mk_dictionary(dict->m_data.data(), dict->m_data.size(),
+                                                            reinterpret_cast<void *>(dict_header.base_addr + sizeof(olean_header)));
+        g_olean_dictionary_writer = dict.release();
+    }
+    return *g_olean_dictionary_writer;
+}
+
+static void save_olean(std::string const & olean_fn, size_t base_addr, b_obj_arg data, bool is_dict) {
     // we first write to a temp file and then move it to the correct path (possibly deleting an older file)
     // so that we neither expose partially-written files nor modify possibly memory-mapped files
     std::string olean_tmp_fn = olean_fn + ".tmp";
+    olean_header header = {};
+    olean_header_ext header_ext;
+    header.base_addr = base_addr;
+    strncpy(header.githash, LEAN_GITHASH, sizeof(header.githash));
+    olean_dictionary_writer const * dict = nullptr;
+    char const * dict_fn = is_dict ? nullptr : std::getenv(g_olean_dictionary_var);
+    if (dict_fn && *dict_fn) {
+        dict = &get_olean_dictionary_writer(dict_fn);
+        header.version            = 2;
+        header_ext.dict_base_addr = dict->m_base_addr;
+        header_ext.dict_hash      = dict->m_hash;
+    }
+    char const * compress = is_dict ? nullptr : std::getenv(g_olean_compress_var);
+    if (compress && *compress) {
+#ifdef LEAN_USE_ZSTD
+        header.version = 2;
+#else
+        throw exception(sstream() << "failed to write '" << olean_fn << "', compressed .olean files are not supported by this build of Lean");
+#endif
+    }
+    object_compactor compactor(reinterpret_cast<void *>(base_addr + olean_payload_offset(header)));
+    if (dict)
+        compactor.set_dictionary(dict->m_index);
     try {
-        std::ofstream out(olean_tmp_fn, std::ios_base::binary);
-        if (out.fail()) {
-            return io_result_mk_error((sstream() << "failed to create file '" << olean_fn << "'").str());
+        compactor(data);
+    } catch (exception & ex) {
+        throw exception(sstream() << "failed to write '" << olean_fn << "': " << ex.what());
+    }
+    if (dict) {
+        // references into the dictionary are recognized by their address, so the payload must not share addresses with it
+        size_t end      = base_addr + olean_payload_offset(header) + compactor.size();
+        size_t dict_end = dict->m_base_addr + sizeof(olean_header) + dict->m_data.size();
+        if (base_addr < dict_end && dict->m_base_addr < end) {
+            throw exception(sstream() << "failed to write '" << olean_fn << "', its address range overlaps the one of the object dictionary '"
+                            << dict_fn << "'");
         }
+    }
 
+    std::ofstream out(olean_tmp_fn, std::ios_base::binary);
+    if (out.fail()) {
+        throw exception(sstream() << "failed to create file '" << olean_fn << "'");
+    }
+    // see/sync with file format description above
+    out.write(reinterpret_cast<char *>(&header), sizeof(header));
+#ifdef LEAN_USE_ZSTD
+    if (compress && *compress) {
+        std::string compressed;
+        compress_olean_payload(static_cast<char const *>(compactor.data()), compactor.size(), atoi(compress), header_ext, compressed);
+        out.write(reinterpret_cast<char *>(&header_ext), sizeof(header_ext));
+        out.write(compressed.data(), compressed.size());
+    } else
+#endif
+    {
+        if (header.version >= 2)
+            out.write(reinterpret_cast<char *>(&header_ext), sizeof(header_ext));
+        out.write(static_cast<char const *>(compactor.data()), compactor.size());
+    }
+    out.close();
+    while (std::rename(olean_tmp_fn.c_str(), olean_fn.c_str()) != 0) {
+#ifdef LEAN_WINDOWS
+        if (errno == EEXIST) {
+            // Memory-mapped files can be deleted starting with Windows 10 using "POSIX semantics"
+            HANDLE h_olean_fn = CreateFile(olean_fn.c_str(), GENERIC_READ | DELETE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (h_olean_fn == INVALID_HANDLE_VALUE) {
+                throw exception(sstream() << "failed to open '" << olean_fn << "': " << GetLastError());
+            }
+
+            FILE_DISPOSITION_INFO_EX fdi = { FILE_DISPOSITION_FLAG_DELETE | FILE_DISPOSITION_FLAG_POSIX_SEMANTICS };
+            if (SetFileInformationByHandle(h_olean_fn, static_cast<FILE_INFO_BY_HANDLE_CLASS>(21) /* FileDispositionInfoEx */, &fdi, sizeof(fdi)) != 0) {
+                lean_always_assert(CloseHandle(h_olean_fn));
+                continue;
+            } else {
+                throw exception(sstream() << "failed to delete '" << olean_fn << "': " << GetLastError());
+            }
+        }
+#endif
+        throw exception(sstream() << "failed to write '" << olean_fn << "': " << errno << " " << strerror(errno));
+    }
+}
+
+extern "C" LEAN_EXPORT object * lean_save_module_data(b_obj_arg fname, b_obj_arg mod, b_obj_arg mdata, object *) {
+    std::string olean_fn(string_cstr(fname));
+    try {
         // Derive a base address that is uniformly distributed by deterministic, and should most likely
         // work for `mmap` on all interesting platforms
         // NOTE: an overlapping/non-compatible base address does not prevent the module from being imported,
@@ -80,147 +342,235 @@ extern "C" LEAN_EXPORT object * lean_save_module_data(b_obj_arg fname, b_obj_arg
         // Let's start with a hash of the module name. Note that while our string hash is a dubious 32-bit
         // algorithm, the mixing of multiple `Name` parts seems to result in a nicely distributed 64-bit
         // output
-        size_t base_addr = name(mod, true).hash();
-        // x86-64 user space is currently limited to the lower 47 bits
-        // https://en.wikipedia.org/wiki/X86-64#Virtual_address_space_details
-        // On Linux at least, the stack grows down from ~0x7fff... followed by shared libraries, so reserve
-        // a bit of space for them (0x7fff...-0x7f00... = 1TB)
-        base_addr = base_addr % 0x7f0000000000;
-        // `mmap` addresses must be page-aligned. The default (non-huge) page size on x86-64 is 4KB.
-        // `MapViewOfFileEx` addresses must be aligned to the "memory allocation granularity", which is 64KB.
-        base_addr = base_addr & ~((1LL<<16) - 1);
-
-        object_compactor compactor(reinterpret_cast<void *>(base_addr + offsetof(olean_header, data)));
-        compactor(mdata);
-
-        // see/sync with file format description above
-        olean_header header = {};
-        header.base_addr = base_addr;
-        strncpy(header.githash, LEAN_GITHASH, sizeof(header.githash));
-        out.write(reinterpret_cast<char *>(&header), sizeof(header));
-        out.write(static_cast<char const *>(compactor.data()), compactor.size());
-        out.close();
-        while (std::rename(olean_tmp_fn.c_str(), olean_fn.c_str()) != 0) {
-#ifdef LEAN_WINDOWS
-            if (errno == EEXIST) {
-                // Memory-mapped files can be deleted starting with Windows 10 using "POSIX semantics"
-                HANDLE h_olean_fn = CreateFile(olean_fn.c_str(), GENERIC_READ | DELETE, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-                if (h_olean_fn == INVALID_HANDLE_VALUE) {
-                    return io_result_mk_error((sstream() << "failed to open '" << olean_fn << "': " << GetLastError()).str());
-                }
-
-                FILE_DISPOSITION_INFO_EX fdi = { FILE_DISPOSITION_FLAG_DELETE | FILE_DISPOSITION_FLAG_POSIX_SEMANTICS };
-                if (SetFileInformationByHandle(h_olean_fn, static_cast<FILE_INFO_BY_HANDLE_CLASS>(21) /* FileDispositionInfoEx */, &fdi, sizeof(fdi)) != 0) {
-                    lean_always_assert(CloseHandle(h_olean_fn));
-                    continue;
-                } else {
-                    return io_result_mk_error((sstream() << "failed to delete '" << olean_fn << "': " << GetLastError()).str());
-                }
-            }
-#endif
-            return io_result_mk_error((sstream() << "failed to write '" << olean_fn << "': " << errno << " " << strerror(errno)).str());
-        }
+        save_olean(olean_fn, olean_base_addr(name(mod, true).hash()), mdata, /* is_dict */ false);
         return io_result_mk_ok(box(0));
     } catch (exception & ex) {
-        return io_result_mk_error((sstream() << "failed to write '" << olean_fn << "': " << ex.what()).str());
+        return io_result_mk_error(ex.what());
     }
 }
 
-extern "C" LEAN_EXPORT object * lean_read_module_data(object * fname, object *) {
+/*
+@[extern "lean_save_olean_dictionary"]
+opaque saveOleanDictionary (fname : @& System.FilePath) (objs : @& Array NonScalar) : IO Unit */
+extern "C" LEAN_EXPORT object * lean_save_olean_dictionary(b_obj_arg fname, b_obj_arg objs, object *) {
     std::string olean_fn(string_cstr(fname));
     try {
-        std::ifstream in(olean_fn, std::ios_base::binary);
-        if (in.fail()) {
-            return io_result_mk_error((sstream() << "failed to open file '" << olean_fn << "'").str());
-        }
-        /* Get file size */
-        in.seekg(0, in.end);
-        size_t size = in.tellg();
-        in.seekg(0);
+        // A dictionary is not a module, so derive its base address from the file name instead; a dictionary never
+        // references another dictionary.
+        save_olean(olean_fn, olean_base_addr(hash_str(olean_fn.size(), reinterpret_cast<unsigned char const *>(olean_fn.data()), 11)),
+                   objs, /* is_dict */ true);
+        return io_result_mk_ok(box(0));
+    } catch (exception & ex) {
+        return io_result_mk_error(ex.what());
+    }
+}
 
-        olean_header default_header = {};
-        olean_header header;
-        if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
-            return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', invalid header").str());
+static compacted_region const * get_olean_dictionary(std::string const & olean_fn, olean_header_ext const & header_ext);
+
+static compacted_region * mk_olean_region(size_t sz, char * buffer, char * base_addr, bool is_mmap,
+                                          std::function<void()> const & free_data, compacted_region const * dict) {
+    compacted_region * region = new compacted_region(sz, buffer, base_addr, is_mmap, free_data, dict);
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+    // do not report as leak
+    __lsan_ignore_object(region);
+#endif
+#endif
+    return region;
+}
+
+#ifdef LEAN_USE_ZSTD
+/* Reads and decompresses the compressed payload of `olean_fn`, see `LEAN_OLEAN_COMPRESS`. */
+static compacted_region * read_compressed_olean(std::string const & olean_fn, std::ifstream & in, size_t size, olean_header const & header,
+                                                olean_header_ext const & header_ext, compacted_region const * dict) {
+    size_t payload_offset = olean_payload_offset(header);
+    std::unique_ptr<char[]> compressed(new char[size - payload_offset]);
+    if (!in.read(compressed.get(), size - payload_offset)) {
+        throw exception(sstream() << "failed to read file '" << olean_fn << "'");
+    }
+    in.close();
+    char * base_addr = reinterpret_cast<char *>(header.base_addr);
+    char * buffer = nullptr;
+    bool is_mmap = false;
+    std::function<void()> free_data;
+#if defined(LEAN_MMAP) && !defined(LEAN_WINDOWS)
+    // Decompress into anonymous memory at the base address, if available, to avoid relocations. As in `read_olean`,
+    // this requires the dictionary, if any, to be at its base address as well.
+    if (!dict || dict->is_memory_mapped()) {
+        size_t map_size = payload_offset + header_ext.payload_size;
+        char * map = static_cast<char *>(mmap(base_addr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (map == base_addr) {
+            buffer = map + payload_offset;
+            is_mmap = true;
+            free_data = [=]() {
+                lean_always_assert(munmap(map, map_size) == 0);
+            };
+        } else if (map != MAP_FAILED) {
+            lean_always_assert(munmap(map, map_size) == 0);
         }
-        if (memcmp(header.marker, default_header.marker, sizeof(header.marker)) != 0
-            || header.version != default_header.version
+    }
+#endif
+    if (!buffer) {
+        buffer = static_cast<char *>(malloc(header_ext.payload_size));
+        free_data = [=]() {
+            free(buffer);
+        };
+    }
+    if (!decompress_olean_payload(compressed.get(), size - payload_offset, header_ext, buffer)) {
+        free_data();
+        throw exception(sstream() << "failed to read file '" << olean_fn << "', invalid compressed data");
+    }
+#if defined(LEAN_MMAP) && !defined(LEAN_WINDOWS)
+    if (is_mmap) {
+        // compacted objects are never modified, as for `mmap`ed .olean files
+        lean_always_assert(mprotect(base_addr, payload_offset + header_ext.payload_size, PROT_READ) == 0);
+    }
+#endif
+    return mk_olean_region(header_ext.payload_size, buffer, base_addr + payload_offset, is_mmap, free_data, dict);
+}
+#endif
+
+/* Reads the .olean-format file `olean_fn`, trying to `mmap` it at its base address. The payload is not relocated yet,
+   see `compacted_region::read`. If `dict_hash` is not `nullptr`, the file is read as a shared object dictionary and
+   `dict_hash` is set to the hash of its unrelocated payload. */
+static compacted_region * read_olean(std::string const & olean_fn, olean_header & header, uint64 * dict_hash) {
+    std::ifstream in(olean_fn, std::ios_base::binary);
+    if (in.fail()) {
+        throw exception(sstream() << "failed to open file '" << olean_fn << "'");
+    }
+    /* Get file size */
+    in.seekg(0, in.end);
+    size_t size = in.tellg();
+    in.seekg(0);
+
+    olean_header default_header = {};
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        throw exception(sstream() << "failed to read file '" << olean_fn << "', invalid header");
+    }
+    olean_header_ext header_ext;
+    if (memcmp(header.marker, default_header.marker, sizeof(header.marker)) != 0
+        || (header.version != 1 && (header.version != 2 || dict_hash))
+        || (header.version == 2 && !in.read(reinterpret_cast<char *>(&header_ext), sizeof(header_ext)))
 #ifdef LEAN_CHECK_OLEAN_VERSION
-            || strncmp(header.githash, LEAN_GITHASH, sizeof(header.githash)) != 0
+        || strncmp(header.githash, LEAN_GITHASH, sizeof(header.githash)) != 0
 #endif
-        ) {
-            return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "', invalid header").str());
-        }
-        char * base_addr = reinterpret_cast<char *>(header.base_addr);
-        char * buffer = nullptr;
-        bool is_mmap = false;
-        std::function<void()> free_data;
+    ) {
+        throw exception(sstream() << "failed to read file '" << olean_fn << "', invalid header");
+    }
+    size_t payload_offset = olean_payload_offset(header);
+    compacted_region const * dict = header_ext.dict_base_addr != 0 ? get_olean_dictionary(olean_fn, header_ext) : nullptr;
+    if (header_ext.num_blocks != 0) {
+#ifdef LEAN_USE_ZSTD
+        return read_compressed_olean(olean_fn, in, size, header, header_ext, dict);
+#else
+        throw exception(sstream() << "failed to read file '" << olean_fn << "', compressed .olean files are not supported by this build of Lean");
+#endif
+    }
+    char * base_addr = reinterpret_cast<char *>(header.base_addr);
+    char * buffer = nullptr;
+    bool is_mmap = false;
+    std::function<void()> free_data;
 #ifdef LEAN_WINDOWS
-        // `FILE_SHARE_DELETE` is necessary to allow the file to (be marked to) be deleted while in use
-        HANDLE h_olean_fn = CreateFile(olean_fn.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-        if (h_olean_fn == INVALID_HANDLE_VALUE) {
-            return io_result_mk_error((sstream() << "failed to open '" << olean_fn << "': " << GetLastError()).str());
-        }
-        HANDLE h_map = CreateFileMapping(h_olean_fn, NULL, PAGE_READONLY, 0, 0, NULL);
-        if (h_olean_fn == NULL) {
-            return io_result_mk_error((sstream() << "failed to map '" << olean_fn << "': " << GetLastError()).str());
+    // `FILE_SHARE_DELETE` is necessary to allow the file to (be marked to) be deleted while in use
+    HANDLE h_olean_fn = CreateFile(olean_fn.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h_olean_fn == INVALID_HANDLE_VALUE) {
+        throw exception(sstream() << "failed to open '" << olean_fn << "': " << GetLastError());
+    }
+    HANDLE h_map = CreateFileMapping(h_olean_fn, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (h_olean_fn == NULL) {
+        throw exception(sstream() << "failed to map '" << olean_fn << "': " << GetLastError());
+    }
+    buffer = static_cast<char *>(MapViewOfFileEx(h_map, FILE_MAP_READ, 0, 0, 0, base_addr));
+    free_data = [=]() {
+        if (buffer) {
+            lean_always_assert(UnmapViewOfFile(base_addr));
         }
-        buffer = static_cast<char *>(MapViewOfFileEx(h_map, FILE_MAP_READ, 0, 0, 0, base_addr));
-        free_data = [=]() {
-            if (buffer) {
-                lean_always_assert(UnmapViewOfFile(base_addr));
-            }
-            lean_always_assert(CloseHandle(h_map));
-            lean_always_assert(CloseHandle(h_olean_fn));
-        };
+        lean_always_assert(CloseHandle(h_map));
+        lean_always_assert(CloseHandle(h_olean_fn));
+    };
 #else
-        int fd = open(olean_fn.c_str(), O_RDONLY);
-        if (fd == -1) {
-            return io_result_mk_error((sstream() << "failed to open '" << olean_fn << "': " << strerror(errno)).str());
+    int fd = open(olean_fn.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw exception(sstream() << "failed to open '" << olean_fn << "': " << strerror(errno));
+    }
+#ifdef LEAN_MMAP
+    buffer = static_cast<char *>(mmap(base_addr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+#endif
+    close(fd);
+    free_data = [=]() {
+        if (buffer != MAP_FAILED) {
+            lean_always_assert(munmap(buffer, size) == 0);
         }
+    };
+#endif
+    // Without relocations, references into the dictionary are only valid if it is mapped at its base address as well
+    if (buffer && buffer == base_addr && (!dict || dict->is_memory_mapped())) {
+        buffer += payload_offset;
+        is_mmap = true;
+    } else {
 #ifdef LEAN_MMAP
-        buffer = static_cast<char *>(mmap(base_addr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+        free_data();
 #endif
-        close(fd);
+        buffer = static_cast<char *>(malloc(size - payload_offset));
         free_data = [=]() {
-            if (buffer != MAP_FAILED) {
-                lean_always_assert(munmap(buffer, size) == 0);
-            }
+            free(buffer);
         };
-#endif
-        if (buffer && buffer == base_addr) {
-            buffer += sizeof(olean_header);
-            is_mmap = true;
-        } else {
-#ifdef LEAN_MMAP
+        in.read(buffer, size - payload_offset);
+        if (!in) {
             free_data();
-#endif
-            buffer = static_cast<char *>(malloc(size - sizeof(olean_header)));
-            free_data = [=]() {
-                free(buffer);
-            };
-            in.read(buffer, size - sizeof(olean_header));
-            if (!in) {
-                return io_result_mk_error((sstream() << "failed to read file '" << olean_fn << "'").str());
-            }
+            throw exception(sstream() << "failed to read file '" << olean_fn << "'");
         }
-        in.close();
+    }
+    in.close();
+    if (dict_hash)
+        *dict_hash = hash_olean_payload(size - payload_offset, buffer);
 
-        compacted_region * region =
-          new compacted_region(size - sizeof(olean_header), buffer, base_addr + sizeof(olean_header), is_mmap, free_data);
-#if defined(__has_feature)
-#if __has_feature(address_sanitizer)
-        // do not report as leak
-        __lsan_ignore_object(region);
-#endif
-#endif
-        object * mod = region->read();
+    return mk_olean_region(size - payload_offset, buffer, base_addr + payload_offset, is_mmap, free_data, dict);
+}
+
+/* Returns the shared object dictionary referenced by an .olean file with the given header, loading it on first use. */
+static compacted_region const * get_olean_dictionary(std::string const & olean_fn, olean_header_ext const & header_ext) {
+    lock_guard<mutex> lock(*g_olean_dictionary_mutex);
+    if (!g_olean_dictionary) {
+        char const * dict_fn = std::getenv(g_olean_dictionary_var);
+        if (!dict_fn || !*dict_fn) {
+            throw exception(sstream() << "failed to read file '" << olean_fn << "', it references a shared object dictionary but `"
+                            << g_olean_dictionary_var << "` is not set");
+        }
+        olean_header dict_header;
+        compacted_region * dict = read_olean(dict_fn, dict_header, &g_olean_dictionary_hash);
+        try {
+            dict->read();
+        } catch (exception & ex) {
+            throw exception(sstream() << "failed to read '" << dict_fn << "': " << ex.what());
+        }
+        g_olean_dictionary_base_addr = dict_header.base_addr;
+        g_olean_dictionary = dict;
+    }
+    if (g_olean_dictionary_base_addr != header_ext.dict_base_addr || g_olean_dictionary_hash != header_ext.dict_hash) {
+        throw exception(sstream() << "failed to read file '" << olean_fn << "', it was written using a different shared object dictionary than `"
+                        << std::getenv(g_olean_dictionary_var) << "`");
+    }
+    return g_olean_dictionary;
+}
+
+extern "C" LEAN_EXPORT object * lean_read_module_data(object * fname, object *) {
+    std::string olean_fn(string_cstr(fname));
+    try {
+        olean_header header;
+        compacted_region * region = read_olean(olean_fn, header, nullptr);
+        object * mod;
+        try {
+            mod = region->read();
+        } catch (exception & ex) {
+            throw exception(sstream() << "failed to read '" << olean_fn << "': " << ex.what());
+        }
         object * mod_region = alloc_cnstr(0, 2, 0);
         cnstr_set(mod_region, 0, mod);
         cnstr_set(mod_region, 1, box_size_t(reinterpret_cast<size_t>(region)));
         return io_result_mk_ok(mod_region);
     } catch (exception & ex) {
-        return io_result_mk_error((sstream() << "failed to read '" << olean_fn << "': " << ex.what()).str());
+        return io_result_mk_error(ex.what());
     }
 }
 
@@ -232,4 +582,13 @@ extern "C" object * lean_write_module(object * env, object * fname, object *);
 void write_module(environment const & env, std::string const & olean_fn) {
     consume_io_result(lean_write_module(env.to_obj_arg(), mk_string(olean_fn), io_mk_world()));
 }
+
+void initialize_module() {
+    g_olean_dictionary_mutex = new mutex();
+}
+
+void finalize_module() {
+    delete g_olean_dictionary_writer;
+    delete g_olean_dictionary_mutex;
+}
 }
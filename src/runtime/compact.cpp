@@ -25,25 +25,29 @@ Author: Leonardo de Moura
 
 namespace lean {
 
+/* Structural hash of the compacted object `[data, data+sz)`.
+   We store it in the keys of `max_sharing_table` and `dictionary`, so that each object is hashed only once
+   even though it may be looked up in both tables, and rehashing the tables does not need to read the objects again. */
+static unsigned hash_compacted_object(char const * data, size_t sz) {
+    return hash_bytes(sz, reinterpret_cast<unsigned char const *>(data), 17);
+}
+
 struct max_sharing_key {
-    size_t m_offset;
-    size_t m_size;
-    max_sharing_key(size_t offset, size_t sz):m_offset(offset), m_size(sz) {}
+    size_t   m_offset;
+    size_t   m_size;
+    unsigned m_hash;
+    max_sharing_key(size_t offset, size_t sz, unsigned h):m_offset(offset), m_size(sz), m_hash(h) {}
 };
 
 struct max_sharing_hash {
-    object_compactor * m;
-    max_sharing_hash(object_compactor * manager):m(manager) {}
-    unsigned operator()(max_sharing_key const & k) const {
-        return hash_str(k.m_size, reinterpret_cast<unsigned char const *>(m->m_begin) + k.m_offset, 17);
-    }
+    unsigned operator()(max_sharing_key const & k) const { return k.m_hash; }
 };
 
 struct max_sharing_eq {
     object_compactor * m;
     max_sharing_eq(object_compactor * manager):m(manager) {}
     bool operator()(max_sharing_key const & k1, max_sharing_key const & k2) const {
-        if (k1.m_size != k2.m_size) return false;
+        if (k1.m_hash != k2.m_hash || k1.m_size != k2.m_size) return false;
         return memcmp(reinterpret_cast<char*>(m->m_begin) + k1.m_offset, reinterpret_cast<char*>(m->m_begin) + k2.m_offset, k1.m_size) == 0;
     }
 };
@@ -52,10 +56,37 @@ struct max_sharing_eq {
 struct object_compactor::max_sharing_table {
     std::unordered_set<max_sharing_key, max_sharing_hash, max_sharing_eq> m_table;
     max_sharing_table(object_compactor * manager):
-        m_table(LEAN_MAX_SHARING_TABLE_INITIAL_SIZE, max_sharing_hash(manager), max_sharing_eq(manager)) {
+        m_table(LEAN_MAX_SHARING_TABLE_INITIAL_SIZE, max_sharing_hash(), max_sharing_eq(manager)) {
+    }
+};
+
+/* Objects of a shared dictionary, see `object_compactor::set_dictionary`. As in `max_sharing_table`, objects are compared
+   by their compacted representation, which coincides for structurally equal objects whose children all reside in the
+   dictionary. */
+struct dictionary_key {
+    char const * m_data;
+    size_t       m_size;
+    unsigned     m_hash;
+    dictionary_key(char const * data, size_t sz, unsigned h):m_data(data), m_size(sz), m_hash(h) {}
+};
+
+struct dictionary_hash {
+    unsigned operator()(dictionary_key const & k) const { return k.m_hash; }
+};
+
+struct dictionary_eq {
+    bool operator()(dictionary_key const & k1, dictionary_key const & k2) const {
+        return k1.m_hash == k2.m_hash && k1.m_size == k2.m_size && memcmp(k1.m_data, k2.m_data, k1.m_size) == 0;
     }
 };
 
+struct object_compactor::dictionary {
+    std::unordered_set<dictionary_key, dictionary_hash, dictionary_eq> m_table;
+    char const * m_begin;
+    void *       m_base_addr;
+    dictionary(char const * begin, void * base_addr):m_begin(begin), m_base_addr(base_addr) {}
+};
+
 object_compactor::object_compactor(void * base_addr):
     m_max_sharing_table(new max_sharing_table(this)),
     m_base_addr(base_addr),
@@ -100,13 +131,50 @@ void object_compactor::save(object * o, object * new_o) {
     m_obj_table.insert(std::make_pair(o, reinterpret_cast<object_offset>(reinterpret_cast<char*>(new_o) - reinterpret_cast<char*>(m_begin) + reinterpret_cast<size_t>(m_base_addr))));
 }
 
+std::shared_ptr<object_compactor::dictionary const> object_compactor::mk_dictionary(void const * data, size_t sz, void * base_addr) {
+    char const * begin = static_cast<char const *>(data);
+    char const * end   = begin + sz;
+    std::shared_ptr<dictionary> dict = std::make_shared<dictionary>(begin, base_addr);
+    // skip root address, see `object_compactor::operator()`
+    char const * it = begin + sizeof(object_offset);
+    while (it < end) {
+        object * curr = reinterpret_cast<object *>(const_cast<char *>(it));
+        // compacted objects store their size in the header, see `lean_set_non_heap_header`
+        size_t obj_sz = lean_object_byte_size(curr);
+        // `mpz` objects contain absolute pointers to their digits and are never shared, see `insert_mpz`
+        if (lean_ptr_tag(curr) != LeanMPZ)
+            dict->m_table.insert(dictionary_key(it, obj_sz, hash_compacted_object(it, obj_sz)));
+        size_t rem = obj_sz % sizeof(void*);
+        if (rem != 0)
+            obj_sz = obj_sz + sizeof(void*) - rem;
+        it += obj_sz;
+    }
+    return dict;
+}
+
+object_offset object_compactor::find_in_dictionary(object * new_o, size_t new_o_sz, unsigned new_o_hash) {
+    if (!m_dictionary)
+        return g_null_offset;
+    auto it = m_dictionary->m_table.find(dictionary_key(reinterpret_cast<char const *>(new_o), new_o_sz, new_o_hash));
+    if (it == m_dictionary->m_table.end())
+        return g_null_offset;
+    return reinterpret_cast<object_offset>(it->m_data - m_dictionary->m_begin + reinterpret_cast<size_t>(m_dictionary->m_base_addr));
+}
+
 void object_compactor::save_max_sharing(object * o, object * new_o, size_t new_o_sz) {
-    max_sharing_key k(reinterpret_cast<char*>(new_o) - reinterpret_cast<char*>(m_begin), new_o_sz);
+    unsigned h = hash_compacted_object(reinterpret_cast<char const *>(new_o), new_o_sz);
+    max_sharing_key k(reinterpret_cast<char*>(new_o) - reinterpret_cast<char*>(m_begin), new_o_sz, h);
     auto it = m_max_sharing_table->m_table.find(k);
     if (it != m_max_sharing_table->m_table.end()) {
         m_end = new_o;
         new_o = reinterpret_cast<lean_object*>(reinterpret_cast<char*>(m_begin) + it->m_offset);
     } else {
+        object_offset d = find_in_dictionary(new_o, new_o_sz, h);
+        if (d != g_null_offset) {
+            m_end = new_o;
+            m_obj_table.insert(std::make_pair(o, d));
+            return;
+        }
         m_max_sharing_table->m_table.insert(k);
     }
     save(o, new_o);
@@ -361,19 +429,24 @@ void object_compactor::operator()(object * o) {
     *static_cast<object_offset *>(m_begin) = to_offset(o);
 }
 
-compacted_region::compacted_region(size_t sz, void * data, void * base_addr, bool is_mmap, std::function<void()> free_data):
+compacted_region::compacted_region(size_t sz, void * data, void * base_addr, bool is_mmap, std::function<void()> free_data,
+                                   compacted_region const * dict):
     m_base_addr(base_addr),
     m_is_mmap(is_mmap),
     m_free_data(free_data),
     m_begin(data),
     m_next(data),
-    m_end(static_cast<char*>(data)+sz) {
+    m_end(static_cast<char*>(data)+sz),
+    m_size(sz),
+    m_dictionary(dict) {
 }
 
 compacted_region::compacted_region(object_compactor const & c):
     m_begin(malloc(c.size())),
     m_next(m_begin),
-    m_end(static_cast<char*>(m_begin) + c.size()) {
+    m_end(static_cast<char*>(m_begin) + c.size()),
+    m_size(c.size()),
+    m_dictionary(nullptr) {
     memcpy(m_begin, c.data(), c.size());
 }
 
@@ -383,6 +456,10 @@ compacted_region::~compacted_region() {
 
 inline object * compacted_region::fix_object_ptr(object * o) {
     if (lean_is_scalar(o)) return o;
+    if (m_dictionary && !contains_base_addr(o)) {
+        lean_assert(m_dictionary->contains_base_addr(o));
+        return reinterpret_cast<object*>(static_cast<char*>(m_dictionary->m_begin) + (reinterpret_cast<size_t>(o) - reinterpret_cast<size_t>(m_dictionary->m_base_addr)));
+    }
     return reinterpret_cast<object*>(static_cast<char*>(m_begin) + (reinterpret_cast<size_t>(o) - reinterpret_cast<size_t>(m_base_addr)));
 }
 
@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #pragma once
 #include <functional>
 #include <vector>
+#include <memory>
 #include <unordered_map>
 #include "runtime/object.h"
 
@@ -14,11 +15,15 @@ namespace lean {
 typedef lean_object * object_offset;
 
 class LEAN_EXPORT object_compactor {
+public:
+    struct dictionary;
+private:
     struct max_sharing_table;
-    friend struct max_sharing_hash;
     friend struct max_sharing_eq;
     std::unordered_map<object*, object_offset, std::hash<object*>, std::equal_to<object*>> m_obj_table;
     std::unique_ptr<max_sharing_table> m_max_sharing_table;
+    // Optional shared dictionary, see `set_dictionary`
+    std::shared_ptr<dictionary const> m_dictionary;
     std::vector<object*> m_todo;
     std::vector<object_offset> m_tmp;
     // On-disk base address used for `mmap`ing compacted regions without relocations
@@ -31,6 +36,7 @@ class LEAN_EXPORT object_compactor {
     size_t capacity() const { return static_cast<char*>(m_capacity) - static_cast<char*>(m_begin); }
     void save(object * o, object * new_o);
     void save_max_sharing(object * o, object * new_o, size_t new_o_sz);
+    object_offset find_in_dictionary(object * new_o, size_t new_o_sz, unsigned new_o_hash);
     void * alloc(size_t sz);
     object_offset to_offset(object * o);
     void insert_terminator(object * o);
@@ -50,6 +56,14 @@ public:
     ~object_compactor();
     object_compactor operator=(object_compactor const &) = delete;
     object_compactor operator=(object_compactor &&) = delete;
+    /* Index the compacted objects in `[data, data+sz)`, as produced by an `object_compactor` with base address
+       `base_addr`, for use as a shared dictionary by `set_dictionary`. `data` must outlive the result. */
+    static std::shared_ptr<dictionary const> mk_dictionary(void const * data, size_t sz, void * base_addr);
+    /* Use `dict` as a shared dictionary: instead of storing a copy of an object that is structurally equal to a
+       dictionary object, the compacted region references the dictionary object at its address relative to the
+       dictionary's base address. Such a region can only be read back by passing a `compacted_region` of the same
+       dictionary to its constructor. */
+    void set_dictionary(std::shared_ptr<dictionary const> const & dict) { m_dictionary = dict; }
     void operator()(object * o);
     size_t size() const { return static_cast<char*>(m_end) - static_cast<char*>(m_begin); }
     void const * data() const { return m_begin; }
@@ -63,6 +77,12 @@ class LEAN_EXPORT compacted_region {
     void * m_begin;
     void * m_next;
     void * m_end;
+    size_t m_size;
+    // shared dictionary referenced by this region, see `object_compactor::set_dictionary`
+    compacted_region const * m_dictionary;
+    bool contains_base_addr(object * o) const {
+        return reinterpret_cast<size_t>(o) - reinterpret_cast<size_t>(m_base_addr) < m_size;
+    }
     void move(size_t d);
     void move(object * o);
     object * fix_object_ptr(object * o);
@@ -74,8 +94,10 @@ class LEAN_EXPORT compacted_region {
     void fix_mpz(object * o);
 public:
     /* Creates a compacted object region using the given region in memory.
-       This object takes ownership of the region. */
-    compacted_region(size_t sz, void * data, void * base_addr, bool is_mmap, std::function<void()> free_data);
+       This object takes ownership of the region. If the region was produced using a shared dictionary, `dict` must
+       be a region of the same dictionary and must outlive this object. */
+    compacted_region(size_t sz, void * data, void * base_addr, bool is_mmap, std::function<void()> free_data,
+                     compacted_region const * dict = nullptr);
     /* Creates a compacted object region using the object_compactor current state.
        It creates a copy of the compacted region generated by the object compactor. */
     explicit compacted_region(object_compactor const & c);
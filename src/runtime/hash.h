@@ -10,8 +10,16 @@ Author: Leonardo de Moura
 
 namespace lean {
 
+/* Stable hash function (MurmurHash64A). Its values are observable from Lean through `String.hash`,
+   `ByteArray.hash`, and `Name.hash`, and they are stored in .olean files (e.g., in `Name` objects),
+   so it must produce the same result on every platform and in every version. */
 uint64 hash_str(size_t len, unsigned char const * str, uint64 init_value);
 
+/* Fast hash function (wyhash), processing 48 bytes per iteration.
+   Its values are deterministic but may change between versions and platforms, so they must only be
+   used by in-memory hash tables, and never be stored in .olean files or in Lean values that may be. */
+uint64 hash_bytes(size_t len, unsigned char const * str, uint64 seed);
+
 inline uint64 hash(uint64 h, uint64 k) {
     uint64 m = 0xc6a4a7935bd1e995;
     uint64 r = 47;
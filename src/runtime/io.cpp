@@ -503,6 +503,92 @@ extern "C" LEAN_EXPORT obj_res lean_io_prim_handle_get_line(b_obj_arg h, obj_arg
     }
 }
 
+/* Number of bytes left to read from `fp` if it refers to a regular file, and zero otherwise. */
+static size_t handle_remaining_size(FILE * fp) {
+#ifdef LEAN_WINDOWS
+    struct _stat64 st;
+    if (_fstat64(_fileno(fp), &st) != 0 || !S_ISREG(st.st_mode))
+        return 0;
+    int64 pos = _ftelli64(fp);
+#else
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode))
+        return 0;
+    int64 pos = ftello(fp);
+#endif
+    return pos >= 0 && pos < st.st_size ? static_cast<size_t>(st.st_size - pos) : 0;
+}
+
+static object * alloc_read_buffer(size_t capacity, bool str) {
+    // strings need one more byte for the terminating null character
+    return str ? lean_alloc_string(0, capacity + 1, 0) : lean_alloc_sarray(1, 0, capacity);
+}
+
+static char * read_buffer_data(object * o, bool str) {
+    return str ? lean_to_string(o)->m_data : reinterpret_cast<char *>(lean_sarray_cptr(o));
+}
+
+/* Read the rest of `fp` directly into the buffer of a new string (if `str`) or byte array, whose size field is left
+   for the caller to set to the number of bytes read, `sz`. The buffer is sized upfront for regular files so that the
+   contents are copied exactly once. Returns `nullptr` and sets `errno` on failure. */
+static object * handle_read_to_end(FILE * fp, bool str, size_t & sz) {
+    // one spare byte so that the read detecting the end of file does not grow the buffer
+    size_t capacity = handle_remaining_size(fp) + 1;
+    if (capacity == 1)
+        capacity = 4096;
+    object * r = alloc_read_buffer(capacity, str);
+    sz = 0;
+    while (true) {
+        if (sz == capacity) {
+            object * new_r = alloc_read_buffer(2 * capacity, str);
+            memcpy(read_buffer_data(new_r, str), read_buffer_data(r, str), sz);
+            lean_dec_ref(r);
+            r = new_r;
+            capacity *= 2;
+        }
+        sz += std::fread(read_buffer_data(r, str) + sz, 1, capacity - sz, fp);
+        if (sz < capacity) {
+            if (std::ferror(fp)) {
+                int err = errno;
+                lean_dec_ref(r);
+                clearerr(fp);
+                errno = err;
+                return nullptr;
+            }
+            clearerr(fp);
+            return r;
+        }
+    }
+}
+
+/* Handle.readBinToEnd : (@& Handle) → IO ByteArray */
+extern "C" LEAN_EXPORT obj_res lean_io_prim_handle_read_bin_to_end(b_obj_arg h, obj_arg /* w */) {
+    size_t sz;
+    object * r = handle_read_to_end(io_get_handle(h), false, sz);
+    if (!r)
+        return io_result_mk_error(decode_io_error(errno, nullptr));
+    lean_sarray_set_size(r, sz);
+    return io_result_mk_ok(r);
+}
+
+/* Handle.readToEnd? : (@& Handle) → IO (Option String) */
+extern "C" LEAN_EXPORT obj_res lean_io_prim_handle_read_to_end(b_obj_arg h, obj_arg /* w */) {
+    size_t sz;
+    object * r = handle_read_to_end(io_get_handle(h), true, sz);
+    if (!r)
+        return io_result_mk_error(decode_io_error(errno, nullptr));
+    // validate and count code points in a single pass
+    size_t pos = 0, len = 0;
+    if (!validate_utf8(reinterpret_cast<uint8_t const *>(lean_string_cstr(r)), sz, pos, len)) {
+        lean_dec_ref(r);
+        return io_result_mk_ok(box(0));
+    }
+    lean_to_string(r)->m_data[sz] = 0;
+    lean_to_string(r)->m_size     = sz + 1;
+    lean_to_string(r)->m_length   = len;
+    return io_result_mk_ok(mk_option_some(r));
+}
+
 /* Handle.putStr : (@& Handle) → (@& String) → IO Unit */
 extern "C" LEAN_EXPORT obj_res lean_io_prim_handle_put_str(b_obj_arg h, b_obj_arg s, obj_arg /* w */) {
     FILE * fp = io_get_handle(h);
@@ -17,6 +17,9 @@ Revision History:
 
 --*/
 #include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include "runtime/mpn.h"
 #include "runtime/debug.h"
 #include "runtime/buffer.h"
@@ -86,17 +89,93 @@ void mpn_sub(mpn_digit const * a, size_t const lnga,
     }
 }
 
-void mpn_mul(mpn_digit const * a, size_t const lnga,
-             mpn_digit const * b, size_t const lngb,
-             mpn_digit * c) {
+#define DIGIT_BITS (sizeof(mpn_digit)*8)
+#define HALF_BITS (sizeof(mpn_digit)*4)
+#define MASK_FIRST (~((mpn_digit)(-1) >> 1))
+#define FIRST_BITS(N, X) ((X) >> (DIGIT_BITS-(N)))
+#define LAST_BITS(N, X) (((X) << (DIGIT_BITS-(N))) >> (DIGIT_BITS-(N)))
+#define BASE ((mpn_double_digit)0x01 << DIGIT_BITS)
+
+class  mpn_buffer : public buffer<mpn_digit> {
+public:
+    mpn_buffer() : buffer<mpn_digit>() {}
+
+    mpn_buffer(size_t nsz, const mpn_digit & elem = 0):buffer<mpn_digit>() {
+        for (size_t i = 0; i < nsz; i++) push_back(elem);
+    }
+
+    void resize(size_t nsz, const mpn_digit & elem = 0) {
+        buffer<mpn_digit>::resize(static_cast<unsigned>(nsz), elem);
+    }
+
+    mpn_digit & operator[](size_t idx) {
+        return buffer<mpn_digit>::operator[](static_cast<unsigned>(idx));
+    }
+
+    const mpn_digit & operator[](size_t idx) const {
+        return buffer<mpn_digit>::operator[](static_cast<unsigned>(idx));
+    }
+};
+
+/* Operands with fewer digits than `LEAN_MPN_KARATSUBA_THRESHOLD` are multiplied using `mul_basecase`. */
+#define LEAN_MPN_KARATSUBA_THRESHOLD 32
+
+// c[0..n) := a[0..n) + b[0..n), returns the carry. `c` may be equal to `a` or `b`.
+static mpn_digit add_n(mpn_digit * c, mpn_digit const * a, mpn_digit const * b, size_t n) {
+    mpn_double_digit k = 0;
+    for (size_t i = 0; i < n; i++) {
+        k += (mpn_double_digit)a[i] + (mpn_double_digit)b[i];
+        c[i] = (mpn_digit)k;
+        k >>= DIGIT_BITS;
+    }
+    return (mpn_digit)k;
+}
+
+// c[0..n) := c[0..n) + k, returns the carry.
+static mpn_digit add_1(mpn_digit * c, size_t n, mpn_digit k) {
+    for (size_t i = 0; i < n && k != 0; i++) {
+        c[i] += k;
+        k = c[i] < k;
+    }
+    return k;
+}
+
+// c[0..n) := a[0..n) - b[0..n), returns the borrow. `c` may be equal to `a` or `b`.
+static mpn_digit sub_n(mpn_digit * c, mpn_digit const * a, mpn_digit const * b, size_t n) {
+    mpn_digit k = 0;
+    for (size_t i = 0; i < n; i++) {
+        mpn_double_digit t = (mpn_double_digit)a[i] - (mpn_double_digit)b[i] - (mpn_double_digit)k;
+        c[i] = (mpn_digit)t;
+        k = (t >> DIGIT_BITS) != 0;
+    }
+    return k;
+}
+
+// c[0..n) := c[0..n) - k, returns the borrow.
+static mpn_digit sub_1(mpn_digit * c, size_t n, mpn_digit k) {
+    for (size_t i = 0; i < n && k != 0; i++) {
+        mpn_digit old = c[i];
+        c[i] -= k;
+        k = c[i] > old;
+    }
+    return k;
+}
+
+static int cmp_n(mpn_digit const * a, mpn_digit const * b, size_t n) {
+    for (size_t i = n; i-- > 0;) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+static void mul_basecase(mpn_digit const * a, size_t const lnga,
+                         mpn_digit const * b, size_t const lngb,
+                         mpn_digit * c) {
     // Essentially Knuth's Algorithm M.
-    // Perhaps implement a more efficient version, see e.g., Knuth, Section 4.3.3.
     size_t i;
     mpn_digit k;
 
-#define DIGIT_BITS (sizeof(mpn_digit)*8)
-#define HALF_BITS (sizeof(mpn_digit)*4)
-
     for (unsigned i = 0; i < lnga; i++)
         c[i] = 0;
 
@@ -122,31 +201,62 @@ void mpn_mul(mpn_digit const * a, size_t const lnga,
     }
 }
 
-#define MASK_FIRST (~((mpn_digit)(-1) >> 1))
-#define FIRST_BITS(N, X) ((X) >> (DIGIT_BITS-(N)))
-#define LAST_BITS(N, X) (((X) << (DIGIT_BITS-(N))) >> (DIGIT_BITS-(N)))
-#define BASE ((mpn_double_digit)0x01 << DIGIT_BITS)
-
-class  mpn_buffer : public buffer<mpn_digit> {
-public:
-    mpn_buffer() : buffer<mpn_digit>() {}
-
-    mpn_buffer(size_t nsz, const mpn_digit & elem = 0):buffer<mpn_digit>() {
-        for (size_t i = 0; i < nsz; i++) push_back(elem);
-    }
+static void mul(mpn_digit const * a, size_t lnga, mpn_digit const * b, size_t lngb, mpn_digit * c);
+
+/* Karatsuba multiplication of `a` and `b`, both of size `n`. `c` must have `2*n` digits.
+   See Knuth, Section 4.3.3. */
+static void mul_karatsuba(mpn_digit const * a, mpn_digit const * b, size_t n, mpn_digit * c) {
+    size_t m = n / 2;    // size of the low halves
+    size_t h = n - m;    // size of the high halves, h >= m
+    mpn_digit const * a0 = a; mpn_digit const * a1 = a + m;
+    mpn_digit const * b0 = b; mpn_digit const * b1 = b + m;
+    // c := a0*b0 + a1*b1*BASE^(2m)
+    mul(a0, m, b0, m, c);
+    mul(a1, h, b1, h, c + 2*m);
+    // t := (a0 + a1)*(b0 + b1) - a0*b0 - a1*b1 = a0*b1 + a1*b0
+    mpn_buffer sa(h+1), sb(h+1), t(2*h+2);
+    for (size_t i = m; i < h; i++) { sa[i] = a1[i]; sb[i] = b1[i]; }
+    sa[h] = add_1(&sa[m], h - m, add_n(sa.data(), a1, a0, m));
+    sb[h] = add_1(&sb[m], h - m, add_n(sb.data(), b1, b0, m));
+    mul(sa.data(), h+1, sb.data(), h+1, t.data());
+    sub_1(&t[2*m], 2*h + 2 - 2*m, sub_n(t.data(), t.data(), c, 2*m));
+    sub_1(&t[2*h], 2, sub_n(t.data(), t.data(), c + 2*m, 2*h));
+    // c := c + t*BASE^m
+    mpn_digit k = add_n(c + m, c + m, t.data(), 2*h + 2);
+    k = add_1(c + m + 2*h + 2, 2*n - m - 2*h - 2, k);
+    lean_assert(k == 0);
+}
 
-    void resize(size_t nsz, const mpn_digit & elem = 0) {
-        buffer<mpn_digit>::resize(static_cast<unsigned>(nsz), elem);
+/* c[0..lnga+lngb) := a * b */
+static void mul(mpn_digit const * a, size_t lnga, mpn_digit const * b, size_t lngb, mpn_digit * c) {
+    if (lnga < lngb) {
+        std::swap(a, b);
+        std::swap(lnga, lngb);
     }
-
-    mpn_digit & operator[](size_t idx) {
-        return buffer<mpn_digit>::operator[](static_cast<unsigned>(idx));
+    if (lngb < LEAN_MPN_KARATSUBA_THRESHOLD) {
+        mul_basecase(a, lnga, b, lngb, c);
+    } else if (lnga == lngb) {
+        mul_karatsuba(a, b, lnga, c);
+    } else {
+        // Unbalanced case: we multiply `b` by chunks of `a` of size `lngb`
+        mpn_buffer t(2*lngb);
+        for (size_t i = 0; i < lnga + lngb; i++)
+            c[i] = 0;
+        for (size_t i = 0; i < lnga; i += lngb) {
+            size_t len = std::min(lngb, lnga - i);
+            mul(a + i, len, b, lngb, t.data());
+            mpn_digit k = add_n(c + i, c + i, t.data(), len + lngb);
+            k = add_1(c + i + len + lngb, lnga - i - len, k);
+            lean_assert(k == 0);
+        }
     }
+}
 
-    const mpn_digit & operator[](size_t idx) const {
-        return buffer<mpn_digit>::operator[](static_cast<unsigned>(idx));
-    }
-};
+void mpn_mul(mpn_digit const * a, size_t const lnga,
+             mpn_digit const * b, size_t const lngb,
+             mpn_digit * c) {
+    mul(a, lnga, b, lngb, c);
+}
 
 static size_t div_normalize(mpn_digit const * numer, size_t const lnum,
                             mpn_digit const * denom, size_t const lden,
@@ -265,6 +375,95 @@ static void div_n(mpn_buffer & numer, mpn_buffer const & denom,
     }
 }
 
+/* `mpn_div` uses `div_bz` when both the divisor and the quotient have at least `LEAN_MPN_DIV_BZ_THRESHOLD` digits.
+   The recursion in `div_2n_1n` stops at divisors with fewer than `LEAN_MPN_BZ_THRESHOLD` digits. */
+#define LEAN_MPN_DIV_BZ_THRESHOLD 512
+#define LEAN_MPN_BZ_THRESHOLD 64
+
+static void div_3n_2n(mpn_digit const * a, mpn_digit const * b, size_t h, mpn_digit * q, mpn_digit * r);
+
+/* Burnikel-Ziegler recursive division, see "Fast Recursive Division", MPI-I-98-1-022.
+   Given `a` with `2*n` digits and a normalized `b` with `n` digits s.t. `a < b*BASE^n`,
+   store the quotient at `q[0..n)` and the remainder at `r[0..n)`. */
+static void div_2n_1n(mpn_digit const * a, mpn_digit const * b, size_t n, mpn_digit * q, mpn_digit * r) {
+    if (n == 1) {
+        mpn_double_digit t = ((mpn_double_digit)a[1] << DIGIT_BITS) | (mpn_double_digit)a[0];
+        q[0] = (mpn_digit)(t / b[0]);
+        r[0] = (mpn_digit)(t % b[0]);
+    } else if (n % 2 != 0 || n < LEAN_MPN_BZ_THRESHOLD) {
+        mpn_buffer u(2*n), v(n), ms, ab;
+        for (size_t i = 0; i < 2*n; i++) u[i] = a[i];
+        for (size_t i = 0; i < n; i++) v[i] = b[i];
+        div_n(u, v, q, r, ms, ab);
+        for (size_t i = 0; i < n; i++) r[i] = u[i];
+    } else {
+        size_t h = n / 2;
+        // a = [a4, a3, a2, a1] (from the least significant half), we divide [a3, a2, a1] and then [a4, r1]
+        mpn_buffer t(3*h);
+        div_3n_2n(a + h, b, h, q + h, t.data() + h);
+        for (size_t i = 0; i < h; i++) t[i] = a[i];
+        div_3n_2n(t.data(), b, h, q, r);
+    }
+}
+
+/* Given `a` with `3*h` digits and a normalized `b` with `2*h` digits s.t. `a < b*BASE^h`,
+   store the quotient at `q[0..h)` and the remainder at `r[0..2h)`. */
+static void div_3n_2n(mpn_digit const * a, mpn_digit const * b, size_t h, mpn_digit * q, mpn_digit * r) {
+    mpn_digit const * a1 = a + 2*h;
+    mpn_digit const * a2 = a + h;
+    mpn_digit const * b1 = b + h;
+    mpn_digit const * b2 = b;
+    // x := [a3, r1] where r1 is the remainder of [a2, a1] divided by b1
+    mpn_buffer x(2*h + 1);
+    for (size_t i = 0; i < h; i++) x[i] = a[i];
+    if (cmp_n(a1, b1, h) < 0) {
+        div_2n_1n(a + h, b1, h, q, &x[h]);
+        x[2*h] = 0;
+    } else {
+        // `a < b*BASE^h` implies `a1 == b1`, the estimated quotient is `BASE^h - 1`
+        lean_assert(cmp_n(a1, b1, h) == 0);
+        for (size_t i = 0; i < h; i++) q[i] = static_cast<mpn_digit>(-1);
+        x[2*h] = add_n(&x[h], a2, b1, h);
+    }
+    // d := q*b2, the estimated remainder is `x - d`, we correct `q` while it is negative
+    mpn_buffer d(2*h);
+    mul(q, h, b2, h, d.data());
+    while (x[2*h] == 0 && cmp_n(x.data(), d.data(), 2*h) < 0) {
+        sub_1(q, h, 1);
+        x[2*h] += add_n(x.data(), x.data(), b, 2*h);
+    }
+    x[2*h] -= sub_n(r, x.data(), d.data(), 2*h);
+    lean_assert(x[2*h] == 0);
+}
+
+/* Similar to `div_n`, but uses `div_2n_1n` on blocks of `numer`. */
+static void div_bz(mpn_buffer & numer, mpn_buffer const & denom, mpn_digit * quot) {
+    size_t m = numer.size() - denom.size();
+    size_t n = denom.size();
+    /* `div_2n_1n` splits the divisor in halves until it is smaller than `LEAN_MPN_BZ_THRESHOLD`.
+       We pad `denom` (and `numer`) with `s` zero digits to make sure the halves have the same size. */
+    size_t k = 1;
+    while (n / k >= LEAN_MPN_BZ_THRESHOLD) k *= 2;
+    size_t bn = ((n + k - 1) / k) * k;
+    size_t s  = bn - n;
+    size_t num_blocks = (m + n + s + bn - 1) / bn;
+    mpn_buffer a(num_blocks * bn), b(bn), t(2*bn), q(bn);
+    for (size_t i = 0; i < m + n; i++) a[s + i] = numer[i];
+    for (size_t i = 0; i < n; i++) b[s + i] = denom[i];
+    // t := [a_i, r] where `r` is the remainder of the previous block
+    for (size_t i = num_blocks; i-- > 0;) {
+        for (size_t j = 0; j < bn; j++) t[j] = a[i*bn + j];
+        div_2n_1n(t.data(), b.data(), bn, q.data(), &t[bn]);
+        for (size_t j = 0; j < bn; j++) {
+            lean_assert(i*bn + j < m || q[j] == 0);
+            if (i*bn + j < m)
+                quot[i*bn + j] = q[j];
+        }
+    }
+    for (size_t i = 0; i < n; i++) numer[i] = t[bn + s + i];
+    for (size_t i = n; i < m + n; i++) numer[i] = 0;
+}
+
 void mpn_div(mpn_digit const * numer, size_t const lnum,
              mpn_digit const * denom, size_t const lden,
              mpn_digit * quot,
@@ -300,6 +499,8 @@ void mpn_div(mpn_digit const * numer, size_t const lnum,
         size_t d = div_normalize(numer, lnum, denom, lden, u, v);
         if (lden == 1)
             div_1(u, v[0], quot);
+        else if (lden >= LEAN_MPN_DIV_BZ_THRESHOLD && lnum - lden >= LEAN_MPN_DIV_BZ_THRESHOLD)
+            div_bz(u, v, quot);
         else
             div_n(u, v, quot, rem, t_ms, t_ab);
         div_unnormalize(u, v, d, rem);
@@ -318,6 +519,51 @@ void mpn_div(mpn_digit const * numer, size_t const lnum,
 #endif
 }
 
+/* Numbers with fewer digits than `LEAN_MPN_TO_STRING_THRESHOLD` are converted by repeated division by `10^9`. */
+#define LEAN_MPN_TO_STRING_THRESHOLD 30
+#define LEAN_MPN_TEN_POW_9 1000000000u
+
+/* Append the decimal representation of `a[0..lng)` to `out`. If `num_chars != 0`, then
+   we use exactly `num_chars` characters by adding leading zeros.
+   `pows[k]` contains `10^(9*2^k)`. */
+static void to_string_core(mpn_digit const * a, size_t lng, size_t num_chars,
+                           std::vector<mpn_buffer> const & pows, std::string & out) {
+    while (lng > 0 && a[lng-1] == 0) lng--;
+    if (lng < LEAN_MPN_TO_STRING_THRESHOLD) {
+        // base case: `a` is split into chunks of 9 decimal digits
+        mpn_buffer t(lng);
+        for (size_t i = 0; i < lng; i++) t[i] = a[i];
+        std::string r;
+        while (lng > 0) {
+            mpn_double_digit rem = 0;
+            for (size_t i = lng; i-- > 0;) {
+                mpn_double_digit c = (rem << DIGIT_BITS) | t[i];
+                t[i] = (mpn_digit)(c / LEAN_MPN_TEN_POW_9);
+                rem  = c % LEAN_MPN_TEN_POW_9;
+            }
+            while (lng > 0 && t[lng-1] == 0) lng--;
+            for (unsigned i = 0; i < 9; i++) {
+                r.push_back('0' + rem % 10);
+                rem /= 10;
+            }
+        }
+        while (!r.empty() && r.back() == '0') r.pop_back();
+        if (num_chars == 0 && r.empty()) r.push_back('0');
+        while (r.size() < num_chars) r.push_back('0');
+        out.append(r.rbegin(), r.rend());
+    } else {
+        // a = q * 10^(9*2^k) + r, where the divisor has approximately half of the digits of `a`
+        size_t k = 0;
+        while (k + 1 < pows.size() && 2 * pows[k+1].size() <= lng) k++;
+        mpn_buffer const & p = pows[k];
+        size_t r_chars = 9 * (static_cast<size_t>(1) << k);
+        mpn_buffer q(lng - p.size() + 1), r(p.size());
+        mpn_div(a, lng, p.data(), p.size(), q.data(), r.data());
+        to_string_core(q.data(), q.size(), num_chars == 0 ? 0 : num_chars - r_chars, pows, out);
+        to_string_core(r.data(), r.size(), r_chars, pows, out);
+    }
+}
+
 char * mpn_to_string(mpn_digit const * a, size_t const lng, char * buf, size_t const lbuf) {
     lean_assert(buf && lbuf > 0);
 
@@ -329,27 +575,22 @@ char * mpn_to_string(mpn_digit const * a, size_t const lng, char * buf, size_t c
 #endif
     }
     else {
-        mpn_buffer temp(lng, 0), t_numer(lng+1, 0), t_denom(1, 0);
-        for (unsigned i = 0; i < lng; i++)
-            temp[i] = a[i];
-
-        size_t j = 0;
-        mpn_digit rem;
-        mpn_digit ten = 10;
-        while (!temp.empty() && (temp.size() > 1 || temp[0] != 0)) {
-            size_t d = div_normalize(&temp[0], temp.size(), &ten, 1, t_numer, t_denom);
-            div_1(t_numer, t_denom[0], &temp[0]);
-            div_unnormalize(t_numer, t_denom, d, &rem);
-            buf[j++] = '0' + rem;
-            while (!temp.empty() && temp.back() == 0)
-                temp.pop_back();
+        // pows[k] := 10^(9*2^k), we only need powers with at most half of the digits of `a`
+        std::vector<mpn_buffer> pows;
+        pows.push_back(mpn_buffer(1, LEAN_MPN_TEN_POW_9));
+        while (2 * pows.back().size() <= lng / 2 + 1) {
+            mpn_buffer const & p = pows.back();
+            mpn_buffer sq(2 * p.size());
+            mul(p.data(), p.size(), p.data(), p.size(), sq.data());
+            while (sq.back() == 0) sq.pop_back();
+            pows.push_back(sq);
         }
-        buf[j] = 0;
-
-        j--;
-        size_t mid = (j/2) + ((j % 2) ? 1 : 0);
-        for (size_t i = 0; i < mid; i++)
-            std::swap(buf[i], buf[j-i]);
+        std::string r;
+        to_string_core(a, lng, 0, pows, r);
+        lean_assert(r.size() < lbuf);
+        for (size_t i = 0; i < r.size(); i++)
+            buf[i] = r[i];
+        buf[r.size()] = 0;
     }
     return buf;
 }
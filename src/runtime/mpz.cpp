@@ -7,6 +7,7 @@ Author: Leonardo de Moura
 #include <memory>
 #include <string>
 #include <cstring>
+#include <vector>
 #include "runtime/sstream.h"
 #include "runtime/buffer.h"
 #include "runtime/alloc.h"
@@ -114,6 +115,19 @@ size_t mpz::get_size_t() const {
     return static_cast<size_t>(mpz_getlimbn(m_val, 0));
 }
 
+bool mpz::is_int64() const {
+    return mpz_sizeinbase(m_val, 2) <= 63;
+}
+
+int64 mpz::get_int64() const {
+    lean_assert(is_int64());
+    // see `get_size_t`
+    uint64 v = static_cast<uint64>(mpz_getlimbn(m_val, 0));
+    if (sizeof(mp_limb_t) < sizeof(uint64))
+        v |= static_cast<uint64>(mpz_getlimbn(m_val, 1)) << 32;
+    return is_neg() ? -static_cast<int64>(v) : static_cast<int64>(v);
+}
+
 mpz & mpz::operator=(mpz const & v) {
     mpz_set(m_val, v.m_val); return *this;
 }
@@ -288,6 +302,13 @@ void display(std::ostream & out, __mpz_struct const * v) {
     }
 }
 
+std::string mpz::to_hex_string() const {
+    std::string r(mpz_sizeinbase(m_val, 16) + 2, 0);
+    mpz_get_str(&r[0], 16, m_val);
+    r.resize(strlen(r.c_str()));
+    return r;
+}
+
 std::ostream & operator<<(std::ostream & out, mpz const & v) {
     display(out, v.m_val);
     return out;
@@ -323,6 +344,43 @@ void mpz::init() {
     m_digits[0] = 0;
 }
 
+#ifndef LEAN_MPZ_FROM_STRING_THRESHOLD
+#define LEAN_MPZ_FROM_STRING_THRESHOLD 360
+#endif
+
+/* Return the value of the decimal digits `[str, str+n)`. Below `LEAN_MPZ_FROM_STRING_THRESHOLD` digits, we consume 9
+   digits per multiplication. Above it, we split the digits into a high part and a low part of `9*2^k` digits, and
+   combine them using `pows[k] = 10^(9*2^k)`, so that most of the work is done by multiplications of balanced
+   operands, which `mpn_mul` performs in subquadratic time. */
+static mpz decimal_to_mpz(char const * str, size_t n, std::vector<mpz> & pows) {
+    if (n <= LEAN_MPZ_FROM_STRING_THRESHOLD) {
+        mpz r;
+        size_t i = 0;
+        while (i < n) {
+            size_t len = (n - i) % 9 == 0 ? 9 : (n - i) % 9;
+            unsigned chunk = 0, pow = 1;
+            for (size_t j = 0; j < len; j++) {
+                chunk = 10*chunk + static_cast<unsigned>(str[i + j] - '0');
+                pow  *= 10;
+            }
+            r *= pow;
+            r += chunk;
+            i += len;
+        }
+        return r;
+    }
+    size_t k = 0;
+    while ((static_cast<size_t>(18) << k) < n)
+        k++;
+    while (pows.size() <= k)
+        pows.push_back(pows.empty() ? mpz(1000000000u) : pows.back() * pows.back());
+    size_t lo_n = static_cast<size_t>(9) << k;
+    mpz r = decimal_to_mpz(str, n - lo_n, pows);
+    r *= pows[k];
+    r += decimal_to_mpz(str + n - lo_n, lo_n, pows);
+    return r;
+}
+
 void mpz::init_str(char const * v) {
     init();
     char const * str = v;
@@ -330,13 +388,14 @@ void mpz::init_str(char const * v) {
     while (str[0] == ' ') ++str;
     if (str[0] == '-')
         sign = true;
-    while (str[0]) {
-        if ('0' <= str[0] && str[0] <= '9') {
-            operator*=(10);
-            operator+=(static_cast<unsigned>(str[0] - '0'));
-        }
-        ++str;
+    // other characters are ignored
+    std::string digits;
+    for (; str[0]; ++str) {
+        if ('0' <= str[0] && str[0] <= '9')
+            digits += str[0];
     }
+    std::vector<mpz> pows;
+    *this = decimal_to_mpz(digits.data(), digits.size(), pows);
     if (sign)
         neg();
 }
@@ -475,6 +534,16 @@ unsigned int mpz::get_unsigned_int() const {
     return m_digits[0];
 }
 
+bool mpz::is_int64() const {
+    return m_size <= 2 && (mod64() >> 63) == 0;
+}
+
+int64 mpz::get_int64() const {
+    lean_assert(is_int64());
+    uint64 v = mod64();
+    return m_sign ? -static_cast<int64>(v) : static_cast<int64>(v);
+}
+
 size_t mpz::get_size_t() const {
     lean_assert(is_size_t());
     if (sizeof(size_t) == 8) {
@@ -993,6 +1062,28 @@ void gcd(mpz & g, mpz const & a, mpz const & b) {
     }
 }
 
+std::string mpz::to_hex_string() const {
+    static char const digits[] = "0123456789abcdef";
+    std::string r;
+    if (m_sign)
+        r += '-';
+    size_t i = m_size - 1;
+    while (i > 0 && m_digits[i] == 0)
+        i--;
+    // skip leading zeros of the most significant digit
+    int shift = 8*sizeof(mpn_digit) - 4;
+    while (shift > 0 && ((m_digits[i] >> shift) & 0xf) == 0)
+        shift -= 4;
+    for (;; i--) {
+        for (; shift >= 0; shift -= 4)
+            r += digits[(m_digits[i] >> shift) & 0xf];
+        if (i == 0)
+            break;
+        shift = 8*sizeof(mpn_digit) - 4;
+    }
+    return r;
+}
+
 std::ostream & operator<<(std::ostream & out, mpz const & v) {
     if (v.m_sign)
         out << "-";
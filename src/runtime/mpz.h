@@ -139,6 +139,9 @@ public:
     int get_int() const;
     unsigned int get_unsigned_int() const;
     size_t get_size_t() const;
+    /* Return true iff the absolute value is smaller than 2^63, i.e., both the value and its negation fit in an `int64`. */
+    bool is_int64() const;
+    int64 get_int64() const;
 
     mpz & operator=(mpz const & v);
     mpz & operator=(mpz && v) { swap(*this, v); return *this; }
@@ -287,6 +290,8 @@ public:
     LEAN_EXPORT friend std::ostream & operator<<(std::ostream & out, mpz const & v);
 
     std::string to_string() const;
+    /* Hexadecimal representation using lowercase digits. */
+    std::string to_hex_string() const;
 };
 
 struct mpz_cmp_fn {
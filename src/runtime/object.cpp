@@ -9,6 +9,7 @@ Author: Leonardo de Moura
 #include <vector>
 #include <deque>
 #include <cmath>
+#include <limits>
 #include <lean/lean.h>
 #include "runtime/object.h"
 #include "runtime/thread.h"
@@ -366,7 +367,75 @@ extern "C" LEAN_EXPORT lean_obj_res lean_array_set_panic(lean_obj_arg a, lean_ob
 // =======================================
 // Thunks
 
+#ifdef LEAN_RUNTIME_STATS
+static atomic<uint64> g_num_thunk_eval(0);
+static atomic<uint64> g_num_thunk_contended(0);
+static atomic<uint64> g_num_thunk_blocked(0);
+struct thunk_stats {
+    ~thunk_stats() {
+        std::cerr << "num. thunk eval.:      " << g_num_thunk_eval << "\n";
+        std::cerr << "num. thunk contended:  " << g_num_thunk_contended << "\n";
+        std::cerr << "num. thunk blocked:    " << g_num_thunk_blocked << "\n";
+    }
+};
+static thunk_stats g_thunk_stats;
+#define LEAN_RUNTIME_STAT_CODE(c) c
+#else
+#define LEAN_RUNTIME_STAT_CODE(c)
+#endif
+
+#ifdef LEAN_MULTI_THREAD
+/* Number of times a thread forcing a thunk that is being evaluated by another thread
+   checks for the result before blocking. */
+#define LEAN_THUNK_SPIN_ITERATIONS 64
+#define LEAN_THUNK_WAIT_SLOTS      64
+
+/* Threads waiting for a thunk being evaluated by another thread block on one of these slots.
+   The slot is selected using the thunk address, so we do not need extra fields in `lean_thunk_object`.
+   Threads waiting for different thunks may share a slot, so they must check `m_value` after waking up. */
+struct thunk_wait_slot {
+    mutex              m_mutex;
+    condition_variable m_cv;
+    atomic<unsigned>   m_num_waiters;
+    thunk_wait_slot():m_num_waiters(0) {}
+};
+
+static thunk_wait_slot * g_thunk_wait_slots = nullptr;
+
+static thunk_wait_slot & get_thunk_wait_slot(b_obj_arg t) {
+    return g_thunk_wait_slots[(reinterpret_cast<size_t>(t) >> 3) % LEAN_THUNK_WAIT_SLOTS];
+}
+#endif
+
+/* Wait for the thread that took `m_closure` to store the result at `m_value`. */
+static b_obj_res thunk_wait(b_obj_arg t) {
+    LEAN_RUNTIME_STAT_CODE(g_num_thunk_contended++);
+#ifdef LEAN_MULTI_THREAD
+    // Most thunks are cheap to evaluate, so we first try to avoid blocking.
+    for (unsigned i = 0; i < LEAN_THUNK_SPIN_ITERATIONS; i++) {
+        if (object * r = lean_to_thunk(t)->m_value)
+            return r;
+        this_thread::yield();
+    }
+    LEAN_RUNTIME_STAT_CODE(g_num_thunk_blocked++);
+    thunk_wait_slot & s = get_thunk_wait_slot(t);
+    unique_lock<mutex> lock(s.m_mutex);
+    /* Remark: `m_num_waiters` must be incremented before we check `m_value`. See `lean_thunk_get_core`. */
+    s.m_num_waiters++;
+    while (!lean_to_thunk(t)->m_value) {
+        s.m_cv.wait(lock);
+    }
+    s.m_num_waiters--;
+#else
+    while (!lean_to_thunk(t)->m_value) {
+        this_thread::yield();
+    }
+#endif
+    return lean_to_thunk(t)->m_value;
+}
+
 extern "C" LEAN_EXPORT b_obj_res lean_thunk_get_core(b_obj_arg t) {
+    /* Only the thread that takes `m_closure` evaluates the thunk. */
     object * c = lean_to_thunk(t)->m_closure.exchange(nullptr);
     if (c != nullptr) {
         /* Recall that a closure uses the standard calling convention.
@@ -376,20 +445,26 @@ extern "C" LEAN_EXPORT b_obj_res lean_thunk_get_core(b_obj_arg t) {
            to be object stored in the constructor object.
 
            Recall that `apply_1` also consumes `c`'s RC. */
+        LEAN_RUNTIME_STAT_CODE(g_num_thunk_eval++);
         object * r = lean_apply_1(c, lean_box(0));
         lean_assert(r != nullptr); /* Closure must return a valid lean object */
         lean_assert(lean_to_thunk(t)->m_value == nullptr);
         mark_mt(r);
         lean_to_thunk(t)->m_value = r;
+#ifdef LEAN_MULTI_THREAD
+        /* Both `m_value` and `m_num_waiters` are sequentially consistent. So, either we see the waiter here, or
+           the waiter sees `m_value` before blocking. We check the slot even if `t` is not marked as multi-threaded
+           since it may have been marked while we were evaluating the closure. */
+        thunk_wait_slot & s = get_thunk_wait_slot(t);
+        if (s.m_num_waiters > 0) {
+            lock_guard<mutex> lock(s.m_mutex);
+            s.m_cv.notify_all();
+        }
+#endif
         return r;
     } else {
-        lean_assert(c == nullptr);
-        /* There is another thread executing the closure. We keep waiting for the m_value to be
-           set by another thread. */
-        while (!lean_to_thunk(t)->m_value) {
-            this_thread::yield();
-        }
-        return lean_to_thunk(t)->m_value;
+        /* There is another thread executing the closure. */
+        return thunk_wait(t);
     }
 }
 
@@ -1081,6 +1156,14 @@ object * alloc_mpz(mpz const & m) {
     return (lean_object*)o;
 }
 
+/* Remark: moving the temporaries produced by `mpz` arithmetic into the new object avoids copying their digits. */
+object * alloc_mpz(mpz && m) {
+    void * mem = lean_alloc_small_object(sizeof(mpz_object));
+    mpz_object * o = new (mem) mpz_object(std::move(m));
+    lean_set_st_header((lean_object*)o, LeanMPZ, 0);
+    return (lean_object*)o;
+}
+
 #ifdef LEAN_USE_GMP
 extern "C" LEAN_EXPORT lean_object * lean_alloc_mpz(mpz_t v) {
     return alloc_mpz(mpz(v));
@@ -1103,6 +1186,13 @@ static inline obj_res mpz_to_nat(mpz const & m) {
         return mpz_to_nat_core(m);
 }
 
+static inline obj_res mpz_to_nat(mpz && m) {
+    if (m.is_size_t() && m.get_size_t() <= LEAN_MAX_SMALL_NAT)
+        return lean_box(m.get_size_t());
+    else
+        return alloc_mpz(std::move(m));
+}
+
 extern "C" LEAN_EXPORT object * lean_cstr_to_nat(char const * n) {
     return mpz_to_nat(mpz(n));
 }
@@ -1351,13 +1441,58 @@ inline object * mpz_to_int_core(mpz const & m) {
     return alloc_mpz(m);
 }
 
-static object * mpz_to_int(mpz const & m) {
+inline object * mpz_to_int_core(mpz && m) {
+    lean_assert(m < LEAN_MIN_SMALL_INT || m > LEAN_MAX_SMALL_INT);
+    return alloc_mpz(std::move(m));
+}
+
+static object * mpz_to_int(mpz && m) {
     if (m < LEAN_MIN_SMALL_INT || m > LEAN_MAX_SMALL_INT)
-        return mpz_to_int_core(m);
+        return mpz_to_int_core(std::move(m));
     else
         return lean_box(static_cast<unsigned>(m.get_int()));
 }
 
+/* If `a` is a scalar, or a big integer whose absolute value is smaller than 2^63, store its value in `r`.
+   The big integer operations below use it to compute with machine integers instead of `mpz` temporaries
+   when both operands are moderately large. */
+static inline bool int_to_int64(b_obj_arg a, int64 & r) {
+    if (lean_is_scalar(a)) {
+        r = lean_scalar_to_int64(a);
+        return true;
+    }
+    mpz const & m = mpz_value(a);
+    if (!m.is_int64())
+        return false;
+    r = m.get_int64();
+    return true;
+}
+
+static inline bool int64_add_overflow(int64 a, int64 b, int64 & r) {
+    if ((b > 0 && a > std::numeric_limits<int64>::max() - b) ||
+        (b < 0 && a < std::numeric_limits<int64>::min() - b))
+        return true;
+    r = a + b;
+    return false;
+}
+
+static inline bool int64_mul_overflow(int64 a, int64 b, int64 & r) {
+#ifdef __SIZEOF_INT128__
+    __int128 p = static_cast<__int128>(a) * b;
+    if (p < std::numeric_limits<int64>::min() || p > std::numeric_limits<int64>::max())
+        return true;
+    r = static_cast<int64>(p);
+    return false;
+#else
+    // conservative: only products of 32-bit numbers
+    if (a < std::numeric_limits<int>::min() || a > std::numeric_limits<int>::max() ||
+        b < std::numeric_limits<int>::min() || b > std::numeric_limits<int>::max())
+        return true;
+    r = a * b;
+    return false;
+#endif
+}
+
 extern "C" LEAN_EXPORT lean_obj_res lean_big_int_to_nat(lean_obj_arg a) {
     lean_assert(!lean_is_scalar(a));
     mpz m = mpz_value(a);
@@ -1390,6 +1525,9 @@ extern "C" LEAN_EXPORT object * lean_int_big_neg(object * a) {
 }
 
 extern "C" LEAN_EXPORT object * lean_int_big_add(object * a1, object * a2) {
+    int64 v1, v2, r;
+    if (int_to_int64(a1, v1) && int_to_int64(a2, v2) && !int64_add_overflow(v1, v2, r))
+        return lean_int64_to_int(r);
     if (lean_is_scalar(a1))
         return mpz_to_int(lean_scalar_to_int(a1) + mpz_value(a2));
     else if (lean_is_scalar(a2))
@@ -1399,6 +1537,10 @@ extern "C" LEAN_EXPORT object * lean_int_big_add(object * a1, object * a2) {
 }
 
 extern "C" LEAN_EXPORT object * lean_int_big_sub(object * a1, object * a2) {
+    int64 v1, v2, r;
+    // `-v2` does not overflow, see `int_to_int64`
+    if (int_to_int64(a1, v1) && int_to_int64(a2, v2) && !int64_add_overflow(v1, -v2, r))
+        return lean_int64_to_int(r);
     if (lean_is_scalar(a1))
         return mpz_to_int(lean_scalar_to_int(a1) - mpz_value(a2));
     else if (lean_is_scalar(a2))
@@ -1408,6 +1550,9 @@ extern "C" LEAN_EXPORT object * lean_int_big_sub(object * a1, object * a2) {
 }
 
 extern "C" LEAN_EXPORT object * lean_int_big_mul(object * a1, object * a2) {
+    int64 v1, v2, r;
+    if (int_to_int64(a1, v1) && int_to_int64(a2, v2) && !int64_mul_overflow(v1, v2, r))
+        return lean_int64_to_int(r);
     if (lean_is_scalar(a1))
         return mpz_to_int(lean_scalar_to_int(a1) * mpz_value(a2));
     else if (lean_is_scalar(a2))
@@ -1417,6 +1562,9 @@ extern "C" LEAN_EXPORT object * lean_int_big_mul(object * a1, object * a2) {
 }
 
 extern "C" LEAN_EXPORT object * lean_int_big_div(object * a1, object * a2) {
+    int64 v1, v2;
+    if (int_to_int64(a1, v1) && int_to_int64(a2, v2) && v2 != 0)
+        return lean_int64_to_int(v1 / v2);
     if (lean_is_scalar(a1)) {
         return mpz_to_int(lean_scalar_to_int(a1) / mpz_value(a2));
     } else if (lean_is_scalar(a2)) {
@@ -1431,6 +1579,9 @@ extern "C" LEAN_EXPORT object * lean_int_big_div(object * a1, object * a2) {
 }
 
 extern "C" LEAN_EXPORT object * lean_int_big_mod(object * a1, object * a2) {
+    int64 v1, v2;
+    if (int_to_int64(a1, v1) && int_to_int64(a2, v2) && v2 != 0)
+        return lean_int64_to_int(v1 % v2);
     if (lean_is_scalar(a1)) {
         return mpz_to_int(mpz(lean_scalar_to_int(a1)) % mpz_value(a2));
     } else if (lean_is_scalar(a2)) {
@@ -1447,6 +1598,15 @@ extern "C" LEAN_EXPORT object * lean_int_big_mod(object * a1, object * a2) {
 }
 
 extern "C" LEAN_EXPORT object * lean_int_big_ediv(object * a1, object * a2) {
+    int64 n, d;
+    if (int_to_int64(a1, n) && int_to_int64(a2, d) && d != 0) {
+        /* See `lean_int_ediv` */
+        int64 q = n / d;
+        int64 r = n % d;
+        if (r < 0)
+            q = (d > 0) ? q - 1 : q + 1;
+        return lean_int64_to_int(q);
+    }
     if (lean_is_scalar(a1)) {
         return mpz_to_int(mpz::ediv(lean_scalar_to_int(a1), mpz_value(a2)));
     } else if (lean_is_scalar(a2)) {
@@ -1461,6 +1621,14 @@ extern "C" LEAN_EXPORT object * lean_int_big_ediv(object * a1, object * a2) {
 }
 
 extern "C" LEAN_EXPORT object * lean_int_big_emod(object * a1, object * a2) {
+    int64 n, d;
+    if (int_to_int64(a1, n) && int_to_int64(a2, d) && d != 0) {
+        /* See `lean_int_emod` */
+        int64 r = n % d;
+        if (r < 0)
+            r = (d > 0) ? r + d : r - d;
+        return lean_int64_to_int(r);
+    }
     if (lean_is_scalar(a1)) {
         return mpz_to_int(mpz::emod(lean_scalar_to_int(a1), mpz_value(a2)));
     } else if (lean_is_scalar(a2)) {
@@ -1686,6 +1854,18 @@ static size_t mk_capacity(size_t sz) {
     return sz*2;
 }
 
+/* Return a string with the contents of `s` and room for at least `extra` additional bytes.
+   `s` is reused when it is exclusive. */
+static object * string_reserve(object * s, size_t extra) {
+    if (lean_is_exclusive(s))
+        return string_ensure_capacity(s, extra);
+    size_t sz = lean_string_size(s);
+    object * r = lean_alloc_string(sz, mk_capacity(sz + extra), lean_string_len(s));
+    memcpy(w_string_cstr(r), lean_string_cstr(s), sz);
+    lean_dec_ref(s);
+    return r;
+}
+
 extern "C" LEAN_EXPORT object * lean_string_push(object * s, unsigned c) {
     size_t sz  = lean_string_size(s);
     size_t len = lean_string_len(s);
@@ -1711,6 +1891,16 @@ extern "C" LEAN_EXPORT object * lean_string_append(object * s1, object * s2) {
     size_t len2     = lean_string_len(s2);
     size_t new_len  = len1 + len2;
     size_t new_sz   = sz1 + sz2 - 1;
+    if (sz2 == 1) {
+        /* `s1 ++ ""` */
+        return s1;
+    }
+    if (sz1 == 1) {
+        /* `"" ++ s2`: share `s2` instead of copying it. This is the common first step when accumulating output. */
+        lean_dec_ref(s1);
+        lean_inc_ref(s2);
+        return s2;
+    }
     object * r;
     if (!lean_is_exclusive(s1)) {
         r = lean_alloc_string(new_sz, mk_capacity(new_sz), new_len);
@@ -1727,6 +1917,81 @@ extern "C" LEAN_EXPORT object * lean_string_append(object * s1, object * s2) {
     return r;
 }
 
+extern "C" LEAN_EXPORT object * lean_string_pushn(object * s, unsigned c, b_obj_arg n0) {
+    if (!lean_is_scalar(n0))
+        lean_internal_panic_out_of_memory();
+    size_t n = lean_unbox(n0);
+    if (n == 0)
+        return s;
+    char buf[8];
+    unsigned csz = push_unicode_scalar(buf, c);
+    size_t sz    = lean_string_size(s);
+    if (n > (std::numeric_limits<size_t>::max() - sz) / csz)
+        lean_internal_panic_out_of_memory();
+    object * r = string_reserve(s, n * csz);
+    char * it  = w_string_cstr(r) + sz - 1;
+    if (csz == 1) {
+        memset(it, buf[0], n);
+    } else {
+        for (size_t i = 0; i < n; i++, it += csz)
+            memcpy(it, buf, csz);
+    }
+    lean_to_string(r)->m_size    = sz + n * csz;
+    lean_to_string(r)->m_length += n;
+    w_string_cstr(r)[sz + n * csz - 1] = 0;
+    return r;
+}
+
+/* Concatenate the strings in the list `l`, separated by `sep` (if not null).
+   The size of the result is computed upfront so that every piece is copied exactly once. */
+static object * string_intercalate(b_obj_arg sep, b_obj_arg l) {
+    if (lean_is_scalar(l))
+        return lean_mk_string_unchecked("", 0, 0);
+    if (lean_is_scalar(lean_ctor_get(l, 1))) {
+        object * s = lean_ctor_get(l, 0);
+        lean_inc_ref(s);
+        return s;
+    }
+    size_t sep_sz  = sep ? lean_string_size(sep) - 1 : 0;
+    size_t sep_len = sep ? lean_string_len(sep) : 0;
+    size_t sz  = 0;
+    size_t len = 0;
+    for (b_obj_arg it = l; !lean_is_scalar(it); it = lean_ctor_get(it, 1)) {
+        b_obj_arg s = lean_ctor_get(it, 0);
+        if (it != l) {
+            sz  += sep_sz;
+            len += sep_len;
+        }
+        sz  += lean_string_size(s) - 1;
+        len += lean_string_len(s);
+    }
+    object * r = lean_alloc_string(sz + 1, sz + 1, len);
+    char * out = w_string_cstr(r);
+    for (b_obj_arg it = l; !lean_is_scalar(it); it = lean_ctor_get(it, 1)) {
+        b_obj_arg s = lean_ctor_get(it, 0);
+        if (sep && it != l) {
+            memcpy(out, lean_string_cstr(sep), sep_sz);
+            out += sep_sz;
+        }
+        size_t s_sz = lean_string_size(s) - 1;
+        memcpy(out, lean_string_cstr(s), s_sz);
+        out += s_sz;
+    }
+    *out = 0;
+    return r;
+}
+
+extern "C" LEAN_EXPORT object * lean_string_join(b_obj_arg l) {
+    return string_intercalate(nullptr, l);
+}
+
+extern "C" LEAN_EXPORT object * lean_string_intercalate(obj_arg sep, obj_arg l) {
+    object * r = string_intercalate(sep, l);
+    lean_dec(sep);
+    lean_dec(l);
+    return r;
+}
+
 extern "C" LEAN_EXPORT bool lean_string_eq_cold(b_lean_obj_arg s1, b_lean_obj_arg s2) {
     return std::memcmp(lean_string_cstr(s1), lean_string_cstr(s2), lean_string_size(s1)) == 0;
 }
@@ -1951,6 +2216,41 @@ extern "C" LEAN_EXPORT obj_res lean_string_utf8_next(b_obj_arg s, b_obj_arg i0)
     return lean_box(i+1);
 }
 
+extern "C" LEAN_EXPORT obj_res lean_string_utf8_next_n(b_obj_arg s, b_obj_arg i0, b_obj_arg n0) {
+    if (!lean_is_scalar(i0)) {
+        /* See comment at string_utf8_get */
+        return lean_nat_add(i0, n0);
+    }
+    usize i = lean_unbox(i0);
+    char const * str = lean_string_cstr(s);
+    usize size       = lean_string_size(s) - 1;
+    if (lean_is_scalar(n0)) {
+        usize n = lean_unbox(n0);
+        i = utf8_next_n(str, size, i, n);
+        /* Each step after reaching the end advances by one byte, see `lean_string_utf8_next`. */
+        return lean_usize_to_nat(i + n);
+    }
+    /* `n0` is bigger than the number of characters in `s`. */
+    usize n = size;
+    i = utf8_next_n(str, size, i, n);
+    obj_res rem = lean_nat_sub(n0, lean_box(size - n));
+    obj_res r   = lean_nat_add(lean_box(i), rem);
+    lean_dec(rem);
+    return r;
+}
+
+extern "C" LEAN_EXPORT obj_res lean_string_utf8_count(b_obj_arg s, b_obj_arg b0, b_obj_arg e0) {
+    if (!lean_is_scalar(b0)) {
+        /* See comment at string_utf8_get */
+        return lean_box(0);
+    }
+    usize b    = lean_unbox(b0);
+    usize size = lean_string_size(s) - 1;
+    /* A big `e0` is never reached, so we count up to the end of the string. */
+    usize e    = lean_is_scalar(e0) ? lean_unbox(e0) : size;
+    return lean_usize_to_nat(utf8_count(lean_string_cstr(s), size, b, e));
+}
+
 extern "C" LEAN_EXPORT obj_res lean_string_utf8_next_fast_cold(size_t i, unsigned char c) {
     if ((c & 0xe0) == 0xc0) return lean_box(i+2);
     if ((c & 0xf0) == 0xe0) return lean_box(i+3);
@@ -1995,6 +2295,13 @@ extern "C" LEAN_EXPORT obj_res lean_string_utf8_extract(b_obj_arg s, b_obj_arg b
     /* In the reference implementation if `e` is not pointing to a valid UTF8
        character start position, it is assumed to be at the end. */
     if (e < sz && !is_utf8_first_byte(str[e])) e = sz;
+    if (b == 0 && e == sz) {
+        /* The whole string, share it instead of copying. Proper substrings are always copied: strings are flat
+           buffers that generated code accesses directly (`lean_string_cstr`), so they cannot point into another
+           string. `Substring` is the non-copying view. */
+        lean_inc_ref(s);
+        return s;
+    }
     usize new_sz = e - b;
     lean_assert(new_sz > 0);
     return lean_mk_string_from_bytes_unchecked(lean_string_cstr(s) + b, new_sz);
@@ -2058,8 +2365,76 @@ extern "C" LEAN_EXPORT uint64 lean_string_hash(b_obj_arg s) {
     return hash_str(sz, (unsigned char const *) str, 11);
 }
 
+static char const g_decimal_digit_pairs[] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+/* Write the decimal representation of `n` right before `end`, and return a pointer to its first character.
+   We emit two digits per division using `g_decimal_digit_pairs`. */
+static char * usize_to_decimal(size_t n, char * end) {
+    while (n >= 100) {
+        size_t r = n % 100;
+        n /= 100;
+        end -= 2;
+        memcpy(end, g_decimal_digit_pairs + 2*r, 2);
+    }
+    if (n >= 10) {
+        end -= 2;
+        memcpy(end, g_decimal_digit_pairs + 2*n, 2);
+    } else {
+        *--end = static_cast<char>('0' + n);
+    }
+    return end;
+}
+
 extern "C" LEAN_EXPORT obj_res lean_string_of_usize(size_t n) {
-    return mk_ascii_string_unchecked(std::to_string(n));
+    char buffer[24];
+    char * end   = buffer + sizeof(buffer);
+    char * begin = usize_to_decimal(n, end);
+    return lean_mk_string_unchecked(begin, end - begin, end - begin);
+}
+
+extern "C" LEAN_EXPORT obj_res lean_nat_to_decimal_string(b_obj_arg n) {
+    if (lean_is_scalar(n))
+        return lean_string_of_usize(lean_unbox(n));
+    else
+        return mk_ascii_string_unchecked(mpz_value(n).to_string());
+}
+
+extern "C" LEAN_EXPORT obj_res lean_nat_to_hex_string(b_obj_arg n) {
+    if (lean_is_scalar(n)) {
+        static char const digits[] = "0123456789abcdef";
+        char buffer[24];
+        char * end   = buffer + sizeof(buffer);
+        char * begin = end;
+        size_t v     = lean_unbox(n);
+        do {
+            *--begin = digits[v & 0xf];
+            v >>= 4;
+        } while (v != 0);
+        return lean_mk_string_unchecked(begin, end - begin, end - begin);
+    } else {
+        return mk_ascii_string_unchecked(mpz_value(n).to_hex_string());
+    }
+}
+
+extern "C" LEAN_EXPORT obj_res lean_string_to_nat(b_obj_arg s) {
+    usize sz         = lean_string_size(s) - 1;
+    char const * str = lean_string_cstr(s);
+    if (sz == 0)
+        return lean_box(0);
+    for (usize i = 0; i < sz; i++) {
+        if (str[i] < '0' || str[i] > '9')
+            return lean_box(0);
+    }
+    if (sz <= 19) {
+        // `10^19 - 1 < 2^64`
+        uint64 v = 0;
+        for (usize i = 0; i < sz; i++)
+            v = 10*v + (str[i] - '0');
+        return mk_option_some(lean_uint64_to_nat(v));
+    }
+    return mk_option_some(mpz_to_nat(mpz(str)));
 }
 
 // =======================================
@@ -2171,6 +2546,55 @@ extern "C" LEAN_EXPORT uint64_t lean_byte_array_hash(b_obj_arg a) {
     return hash_str(lean_sarray_size(a), lean_sarray_cptr(a), 11);
 }
 
+extern "C" LEAN_EXPORT uint8 lean_byte_array_beq(b_obj_arg a, b_obj_arg b) {
+    size_t sz = lean_sarray_size(a);
+    return sz == lean_sarray_size(b) && memcmp(lean_sarray_cptr(a), lean_sarray_cptr(b), sz) == 0;
+}
+
+extern "C" LEAN_EXPORT obj_res lean_byte_array_index_of(b_obj_arg a, uint8 b, b_obj_arg o_start) {
+    size_t sz = lean_sarray_size(a);
+    if (!lean_is_scalar(o_start) || lean_unbox(o_start) >= sz)
+        return lean_box(0);
+    uint8 const * data = lean_sarray_cptr(a);
+    size_t start       = lean_unbox(o_start);
+    void const * it    = memchr(data + start, b, sz - start);
+    if (it == nullptr)
+        return lean_box(0);
+    return mk_option_some(lean_usize_to_nat(static_cast<uint8 const *>(it) - data));
+}
+
+extern "C" LEAN_EXPORT obj_res lean_byte_array_fill(obj_arg a, uint8 v, b_obj_arg o_off, b_obj_arg o_len) {
+    size_t sz = lean_sarray_size(a);
+    if (!lean_is_scalar(o_off) || lean_unbox(o_off) >= sz)
+        return a;
+    size_t off = lean_unbox(o_off);
+    size_t len = lean_is_scalar(o_len) ? std::min(lean_unbox(o_len), sz - off) : sz - off;
+    if (len == 0)
+        return a;
+    object * r = lean_sarray_ensure_exclusive(a);
+    memset(lean_sarray_cptr(r) + off, v, len);
+    return r;
+}
+
+/* Replace `a[i]` with `f(a[i], b[i])` for `i < min(size(a), size(b))`.
+   The loop is simple enough for the C compiler to vectorize it. */
+template<typename T, typename F>
+static obj_res sarray_zip_with(obj_arg a, b_obj_arg b, F && f) {
+    size_t n = std::min(lean_sarray_size(a), lean_sarray_size(b));
+    if (n == 0)
+        return a;
+    object * r    = lean_sarray_ensure_exclusive(a);
+    T * it        = reinterpret_cast<T*>(lean_sarray_cptr(r));
+    T const * it2 = reinterpret_cast<T const *>(lean_sarray_cptr(b));
+    for (size_t i = 0; i < n; i++)
+        it[i] = f(it[i], it2[i]);
+    return r;
+}
+
+extern "C" LEAN_EXPORT obj_res lean_byte_array_xor(obj_arg a, b_obj_arg b) {
+    return sarray_zip_with<uint8>(a, b, [](uint8 x, uint8 y) { return static_cast<uint8>(x ^ y); });
+}
+
 extern "C" LEAN_EXPORT obj_res lean_copy_float_array(obj_arg a) {
     return lean_copy_sarray(a, lean_sarray_capacity(a));
 }
@@ -2210,6 +2634,35 @@ extern "C" LEAN_EXPORT obj_res lean_float_array_push(obj_arg a, double d) {
     return r;
 }
 
+extern "C" LEAN_EXPORT obj_res lean_float_array_add(obj_arg a, b_obj_arg b) {
+    return sarray_zip_with<double>(a, b, [](double x, double y) { return x + y; });
+}
+
+extern "C" LEAN_EXPORT obj_res lean_float_array_mul(obj_arg a, b_obj_arg b) {
+    return sarray_zip_with<double>(a, b, [](double x, double y) { return x * y; });
+}
+
+/* Remark: we add from left to right, as the reference implementation does. Reassociating the sum with several
+   accumulators would be faster, but the result would depend on the implementation. */
+extern "C" LEAN_EXPORT double lean_float_array_sum(b_obj_arg a) {
+    double const * it  = lean_float_array_cptr(a);
+    double const * end = it + lean_sarray_size(a);
+    double r = 0.0;
+    for (; it != end; ++it)
+        r += *it;
+    return r;
+}
+
+extern "C" LEAN_EXPORT double lean_float_array_dot(b_obj_arg a, b_obj_arg b) {
+    size_t n           = std::min(lean_sarray_size(a), lean_sarray_size(b));
+    double const * it  = lean_float_array_cptr(a);
+    double const * it2 = lean_float_array_cptr(b);
+    double r = 0.0;
+    for (size_t i = 0; i < n; i++)
+        r += it[i] * it2[i];
+    return r;
+}
+
 // =======================================
 // Array functions for generated code
 
@@ -2374,6 +2827,9 @@ extern "C" LEAN_EXPORT lean_external_class * lean_register_external_class(lean_e
 void initialize_object() {
     g_ext_classes       = new std::vector<external_object_class*>();
     g_ext_classes_mutex = new mutex();
+#ifdef LEAN_MULTI_THREAD
+    g_thunk_wait_slots  = new thunk_wait_slot[LEAN_THUNK_WAIT_SLOTS];
+#endif
     g_array_empty       = lean_alloc_array(0, 0);
     mark_persistent(g_array_empty);
 }
@@ -2382,5 +2838,8 @@ void finalize_object() {
     for (external_object_class * cls : *g_ext_classes) delete cls;
     delete g_ext_classes;
     delete g_ext_classes_mutex;
+#ifdef LEAN_MULTI_THREAD
+    delete[] g_thunk_wait_slots;
+#endif
 }
 }
@@ -4,9 +4,11 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <algorithm>
 #include <cstring>
 #include "runtime/sharecommon.h"
 #include "runtime/hash.h"
+#include "runtime/io.h"
 
 namespace lean {
 
@@ -32,7 +34,7 @@ extern "C" LEAN_EXPORT uint64_t lean_sharecommon_hash(b_obj_arg o) {
     // hash relevant parts of the header
     unsigned init = hash(lean_ptr_tag(o), lean_ptr_other(o));
     // hash body
-    return hash_str(sz - header_sz, reinterpret_cast<unsigned char const *>(o) + header_sz, init);
+    return hash_bytes(sz - header_sz, reinterpret_cast<unsigned char const *>(o) + header_sz, init);
 }
 
 static obj_res mk_pair(obj_arg a, obj_arg b) {
@@ -310,15 +312,15 @@ lean_object * sharecommon_quick_fn::check_cache(lean_object * a) {
 lean_object * sharecommon_quick_fn::save(lean_object * a, lean_object * new_a) {
     lean_assert(lean_is_st(new_a));
     lean_assert(new_a->m_rc == 1);
-    auto it = m_set.find(new_a);
+    // Remark: we use a single `insert` instead of `find` followed by `insert` to avoid hashing `new_a` twice.
+    auto p = m_set.insert(new_a);
     lean_object * result;
-    if (it == m_set.end()) {
+    if (p.second) {
         // `new_a` is a new object
-        m_set.insert(new_a);
         result = new_a;
     } else {
         // We already have a maximally shared object that is equal to `new_a`
-        result = *it;
+        result = *p.first;
         DEBUG_CODE({
                 if (lean_is_ctor(new_a)) {
                     lean_assert(lean_is_ctor(result));
@@ -346,12 +348,7 @@ lean_object * sharecommon_quick_fn::save(lean_object * a, lean_object * new_a) {
 
 // `sarray` and `string`
 lean_object * sharecommon_quick_fn::visit_terminal(lean_object * a) {
-    auto it = m_set.find(a);
-    if (it == m_set.end()) {
-        m_set.insert(a);
-    } else {
-        a = *it;
-    }
+    a = *m_set.insert(a).first;
     lean_inc_ref(a);
     return a;
 }
@@ -432,4 +429,276 @@ lean_object * sharecommon_persistent_fn::operator()(lean_object * e) {
     m_saved.push_back(object_ref(r, true));
     return r;
 }
+
+sharecommon_table::sharecommon_table(unsigned num_shards):
+    m_num_shards(num_shards), m_shards(new shard[num_shards]) {
+    lean_assert(num_shards > 0);
+}
+
+sharecommon_table::~sharecommon_table() {
+    for (unsigned i = 0; i < m_num_shards; i++) {
+        for (entry const & e : m_shards[i].m_set)
+            lean_dec_ref(e.m_obj);
+    }
+}
+
+lean_object * sharecommon_table::find(b_obj_arg o) {
+    entry e(o);
+    shard & s = get_shard(e);
+    lock_guard<mutex> lock(s.m_mutex);
+    auto it = s.m_set.find(e);
+    if (it == s.m_set.end())
+        return nullptr;
+    // We must increment the reference counter while holding the lock, otherwise `prune` may delete the object.
+    lean_inc_ref(it->m_obj);
+    return it->m_obj;
+}
+
+lean_object * sharecommon_table::insert(obj_arg o) {
+    /* The children of `o` are usually in the table already, and `lean_mark_mt` does not visit them again.
+       We mark `o` before acquiring the lock to keep the critical section small. */
+    lean_mark_mt(o);
+    entry e(o);
+    shard & s = get_shard(e);
+    lean_object * r;
+    {
+        lock_guard<mutex> lock(s.m_mutex);
+        auto p = s.m_set.insert(e);
+        if (p.second) {
+            lean_inc_ref(o); // reference owned by the table
+            return o;
+        }
+        r = p.first->m_obj;
+        if (r == o)
+            return o;
+        lean_inc_ref(r);
+    }
+    // We release `o` outside of the critical section since its children may have to be deleted too.
+    lean_dec_ref(o);
+    return r;
+}
+
+/* Return `true` if the reference counter of `o` is `n`. */
+static bool has_rc(lean_object * o, int n) {
+    if (lean_is_mt(o))
+        return std::atomic_load_explicit(lean_get_rc_mt_addr(o), std::memory_order_acquire) == -n;
+    else
+        return o->m_rc == n;
+}
+
+/* Push the children of `o` that may be table entries to `r`. */
+static void push_children(lean_object * o, std::vector<lean_object *> & r) {
+    if (lean_ptr_tag(o) <= LeanMaxCtorTag) {
+        for (unsigned i = 0; i < lean_ctor_num_objs(o); i++) {
+            lean_object * c = lean_ctor_get(o, i);
+            if (!lean_is_scalar(c))
+                r.push_back(c);
+        }
+    } else if (lean_ptr_tag(o) == LeanArray) {
+        for (size_t i = 0; i < lean_array_size(o); i++) {
+            lean_object * c = lean_array_get_core(o, i);
+            if (!lean_is_scalar(c))
+                r.push_back(c);
+        }
+    }
+}
+
+size_t sharecommon_table::prune() {
+    size_t num_removed = 0;
+    // removed entries whose reference is still owned by `prune`
+    std::vector<lean_object *> to_delete;
+    for (unsigned i = 0; i < m_num_shards; i++) {
+        shard & s = m_shards[i];
+        lock_guard<mutex> lock(s.m_mutex);
+        for (auto it = s.m_set.begin(); it != s.m_set.end();) {
+            // Remark: new references to entries are only created while holding the lock of their shard.
+            if (has_rc(it->m_obj, 1)) {
+                to_delete.push_back(it->m_obj);
+                it = s.m_set.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    /* Deleting an entry decrements the reference counters of its children, and they may become dead entries too.
+       Instead of scanning the whole table again, we only re-examine the children of deleted entries. A child is dead
+       after its parent is deleted if the table and the parent own all its references. Since it cannot be found
+       anymore once we remove it from the table, no new references can be created in between. */
+    std::vector<lean_object *> children;
+    while (!to_delete.empty()) {
+        lean_object * o = to_delete.back();
+        to_delete.pop_back();
+        num_removed++;
+        children.clear();
+        push_children(o, children);
+        std::sort(children.begin(), children.end());
+        for (size_t j = 0; j < children.size();) {
+            lean_object * c = children[j];
+            size_t k = j;
+            while (k < children.size() && children[k] == c)
+                k++;
+            entry e(c);
+            shard & s = get_shard(e);
+            lock_guard<mutex> lock(s.m_mutex);
+            auto it = s.m_set.find(e);
+            if (it != s.m_set.end() && it->m_obj == c && has_rc(c, static_cast<int>(k - j) + 1)) {
+                s.m_set.erase(it);
+                to_delete.push_back(c);
+            }
+            j = k;
+        }
+        lean_dec_ref(o);
+    }
+    return num_removed;
+}
+
+size_t sharecommon_table::size() const {
+    size_t r = 0;
+    for (unsigned i = 0; i < m_num_shards; i++) {
+        lock_guard<mutex> lock(m_shards[i].m_mutex);
+        r += m_shards[i].m_set.size();
+    }
+    return r;
+}
+
+/*
+Similar to `sharecommon_quick_fn`, but uses a `sharecommon_table` as the hash-consing table.
+Many `sharecommon_concurrent_fn` objects may share the same table, even in different threads.
+The local cache `m_cache` does not own references to its range for the same reasons described above `sharecommon_quick_fn::check_cache`.
+*/
+class sharecommon_concurrent_fn {
+    sharecommon_table &                              m_table;
+    std::unordered_map<lean_object *, lean_object *> m_cache;
+
+    /* Only objects that have been marked as multi-threaded (or are persistent) can be in `m_table`. */
+    static bool may_be_in_table(lean_object * a) {
+#ifdef LEAN_MULTI_THREAD
+        return !lean_is_st(a);
+#else
+        (void)a;
+        return true;
+#endif
+    }
+
+    lean_object * check_cache(lean_object * a) {
+        if (!lean_is_exclusive(a)) {
+            auto it = m_cache.find(a);
+            if (it != m_cache.end()) {
+                lean_inc_ref(it->second);
+                return it->second;
+            }
+            if (may_be_in_table(a))
+                return m_table.find(a);
+        }
+        return nullptr;
+    }
+
+    lean_object * save(lean_object * a, lean_object * new_a) {
+        lean_object * result = m_table.insert(new_a);
+        if (!lean_is_exclusive(a))
+            m_cache.insert(std::make_pair(a, result));
+        return result;
+    }
+
+    lean_object * visit_terminal(lean_object * a) {
+        if (may_be_in_table(a)) {
+            if (lean_object * r = m_table.find(a))
+                return r;
+        }
+        lean_inc_ref(a);
+        return m_table.insert(a);
+    }
+
+    lean_object * visit_array(lean_object * a) {
+        lean_object * r = check_cache(a);
+        if (r != nullptr) return r;
+        size_t sz = array_size(a);
+        lean_array_object * new_a = (lean_array_object*)lean_alloc_array(sz, sz);
+        for (size_t i = 0; i < sz; i++) {
+            lean_array_set_core((lean_object*)new_a, i, visit(lean_array_get_core(a, i)));
+        }
+        return save(a, (lean_object*)new_a);
+    }
+
+    lean_object * visit_ctor(lean_object * a) {
+        lean_object * r = check_cache(a);
+        if (r != nullptr) return r;
+        unsigned num_objs      = lean_ctor_num_objs(a);
+        unsigned tag           = lean_ptr_tag(a);
+        unsigned sz            = lean_object_byte_size(a);
+        unsigned scalar_offset = sizeof(lean_object) + num_objs*sizeof(void*);
+        unsigned scalar_sz     = sz - scalar_offset;
+        lean_object * new_a    = lean_alloc_ctor(tag, num_objs, scalar_sz);
+        for (unsigned i = 0; i < num_objs; i++) {
+            lean_ctor_set(new_a, i, visit(lean_ctor_get(a, i)));
+        }
+        if (scalar_sz > 0) {
+            memcpy(reinterpret_cast<char*>(new_a) + scalar_offset, reinterpret_cast<char*>(a) + scalar_offset, scalar_sz);
+        }
+        return save(a, new_a);
+    }
+
+    lean_object * visit(lean_object * a) {
+        if (lean_is_scalar(a)) {
+            return a;
+        }
+        switch (lean_ptr_tag(a)) {
+        case LeanMPZ:             lean_inc_ref(a); return a;
+        case LeanClosure:         lean_inc_ref(a); return a;
+        case LeanThunk:           lean_inc_ref(a); return a;
+        case LeanTask:            lean_inc_ref(a); return a;
+        case LeanRef:             lean_inc_ref(a); return a;
+        case LeanExternal:        lean_inc_ref(a); return a;
+        case LeanReserved:        lean_inc_ref(a); return a;
+        case LeanScalarArray:     return visit_terminal(a);
+        case LeanString:          return visit_terminal(a);
+        case LeanArray:           return visit_array(a);
+        default:                  return visit_ctor(a);
+        }
+    }
+public:
+    sharecommon_concurrent_fn(sharecommon_table & t):m_table(t) {}
+    lean_object * operator()(lean_object * a) {
+        return visit(a);
+    }
+};
+
+static lean_external_class * g_sharecommon_table_external_class = nullptr;
+static void sharecommon_table_finalizer(void * t) {
+    delete static_cast<sharecommon_table *>(t);
+}
+static void sharecommon_table_foreach(void *, b_obj_arg) {}
+
+static sharecommon_table * sharecommon_table_get(b_obj_arg t) {
+    return static_cast<sharecommon_table *>(lean_get_external_data(t));
+}
+
+// def ShareCommon.Table.new : BaseIO Table
+extern "C" LEAN_EXPORT obj_res lean_sharecommon_table_new(obj_arg) {
+    return io_result_mk_ok(lean_alloc_external(g_sharecommon_table_external_class, new sharecommon_table()));
+}
+
+// def ShareCommon.Table.shareCommon (t : @& Table) (a : α) : BaseIO α
+extern "C" LEAN_EXPORT obj_res lean_sharecommon_table_share(b_obj_arg t, obj_arg a, obj_arg) {
+    obj_res r = sharecommon_concurrent_fn(*sharecommon_table_get(t))(a);
+    lean_dec(a);
+    return io_result_mk_ok(r);
+}
+
+// def ShareCommon.Table.prune (t : @& Table) : BaseIO Nat
+extern "C" LEAN_EXPORT obj_res lean_sharecommon_table_prune(b_obj_arg t, obj_arg) {
+    return io_result_mk_ok(lean_usize_to_nat(sharecommon_table_get(t)->prune()));
+}
+
+// def ShareCommon.Table.size (t : @& Table) : BaseIO Nat
+extern "C" LEAN_EXPORT obj_res lean_sharecommon_table_size(b_obj_arg t, obj_arg) {
+    return io_result_mk_ok(lean_usize_to_nat(sharecommon_table_get(t)->size()));
+}
+
+void initialize_sharecommon() {
+    g_sharecommon_table_external_class = lean_register_external_class(sharecommon_table_finalizer, sharecommon_table_foreach);
+}
+
+void finalize_sharecommon() {
+}
 };
@@ -8,12 +8,21 @@ Author: Leonardo de Moura
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
+#include <memory>
 #include "runtime/object_ref.h"
+#include "runtime/thread.h"
 
 namespace lean {
 extern "C" LEAN_EXPORT uint8 lean_sharecommon_eq(b_obj_arg o1, b_obj_arg o2);
 extern "C" LEAN_EXPORT uint64_t lean_sharecommon_hash(b_obj_arg o);
 
+struct sharecommon_set_hash {
+    std::size_t operator()(lean_object * o) const { return lean_sharecommon_hash(o); }
+};
+struct sharecommon_set_eq {
+    std::size_t operator()(lean_object * o1, lean_object * o2) const { return lean_sharecommon_eq(o1, o2); }
+};
+
 /*
 A faster version of `sharecommon_fn` which only uses a local state.
 It optimizes the number of RC operations, the strategy for caching results,
@@ -21,20 +30,13 @@ and uses C++ hashmap.
 */
 class LEAN_EXPORT sharecommon_quick_fn {
 protected:
-    struct set_hash {
-        std::size_t operator()(lean_object * o) const { return lean_sharecommon_hash(o); }
-    };
-    struct set_eq {
-        std::size_t operator()(lean_object * o1, lean_object * o2) const { return lean_sharecommon_eq(o1, o2); }
-    };
-
     /*
     We use `m_cache` to ensure we do **not** traverse a DAG as a tree.
     We use pointer equality for this collection.
     */
     std::unordered_map<lean_object *, lean_object *> m_cache;
     /* Set of maximally shared terms. AKA hash-consing table. */
-    std::unordered_set<lean_object *, set_hash, set_eq> m_set;
+    std::unordered_set<lean_object *, sharecommon_set_hash, sharecommon_set_eq> m_set;
     /*
     If `true`, `check_cache` will also check `m_set`.
     This is useful when the input term may contain terms that have already
@@ -68,4 +70,51 @@ public:
     lean_object * operator()(lean_object * e);
 };
 
+/*
+Concurrent and persistent hash-consing table.
+Unlike the set used by `sharecommon_quick_fn`, it can be used by many tasks at the same time, and
+its contents survive across `lean_sharecommon_table_share` invocations.
+The table is split into shards indexed by `lean_sharecommon_hash`, each one protected by its own mutex.
+All objects stored in the table are marked as multi-threaded, and the table owns a reference to each one of them.
+Entries are "weak" in the sense that `prune` drops the ones that are only kept alive by the table.
+*/
+class LEAN_EXPORT sharecommon_table {
+    /* We store the hash code with each entry, it is used to select the shard and for the lookup in it. */
+    struct entry {
+        lean_object * m_obj;
+        uint64_t      m_hash;
+        explicit entry(lean_object * o):m_obj(o), m_hash(lean_sharecommon_hash(o)) {}
+    };
+    struct entry_hash {
+        std::size_t operator()(entry const & e) const { return e.m_hash; }
+    };
+    struct entry_eq {
+        bool operator()(entry const & e1, entry const & e2) const {
+            return e1.m_hash == e2.m_hash && lean_sharecommon_eq(e1.m_obj, e2.m_obj);
+        }
+    };
+    struct shard {
+        mutex                                             m_mutex;
+        std::unordered_set<entry, entry_hash, entry_eq> m_set;
+    };
+    unsigned                 m_num_shards;
+    std::unique_ptr<shard[]> m_shards;
+    shard & get_shard(entry const & e) const { return m_shards[e.m_hash % m_num_shards]; }
+public:
+    explicit sharecommon_table(unsigned num_shards = 64);
+    sharecommon_table(sharecommon_table const &) = delete;
+    ~sharecommon_table();
+    /* Return an object in the table that is structurally equal to `o` (see `lean_sharecommon_eq`), or `nullptr`.
+       The result is owned by the caller. */
+    lean_object * find(b_obj_arg o);
+    /* If the table contains an object structurally equal to `o`, consume `o` and return the existing object.
+       Otherwise, mark `o` as multi-threaded, insert it, and return it. */
+    lean_object * insert(obj_arg o);
+    /* Remove the entries that are only referenced by the table, and return how many were removed. */
+    size_t prune();
+    size_t size() const;
+};
+
+void initialize_sharecommon();
+void finalize_sharecommon();
 };
@@ -5,12 +5,34 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <algorithm>
 #include "runtime/debug.h"
 #include "runtime/optional.h"
 #include "runtime/utf8.h"
 
 namespace lean {
+/* Return `true` if the 8 bytes starting at `str` are ASCII characters.
+   We use it to skip ASCII text, the common case in source files and JSON-RPC messages, 8 bytes at a time.
+   Remark: `memcpy` is compiled into a single unaligned load. */
+static inline bool is_ascii_word(void const * str) {
+    uint64_t w;
+    memcpy(&w, str, sizeof(w));
+    return (w & 0x8080808080808080ull) == 0;
+}
+
+/* Return the size of the longest prefix of `str[0..size)` containing only ASCII characters,
+   rounded down to a multiple of 8. */
+static inline size_t ascii_prefix_size(char const * str, size_t size) {
+    size_t i = 0;
+    while (i + 16 <= size && is_ascii_word(str + i) && is_ascii_word(str + i + 8))
+        i += 16;
+    if (i + 8 <= size && is_ascii_word(str + i))
+        i += 8;
+    return i;
+}
+
 bool is_utf8_next(unsigned char c) { return (c & 0xC0) == 0x80; }
 
 unsigned get_utf8_size(unsigned char c) {
@@ -50,7 +72,16 @@ extern "C" LEAN_EXPORT size_t lean_utf8_n_strlen(char const * str, size_t sz) {
     size_t r = 0;
     size_t i = 0;
     while (i < sz) {
-        unsigned d = get_utf8_size(str[i]);
+        unsigned char c = str[i];
+        if (c < 0x80) {
+            size_t n = ascii_prefix_size(str + i, sz - i);
+            if (n > 0) {
+                r += n;
+                i += n;
+                continue;
+            }
+        }
+        unsigned d = get_utf8_size(c);
         r++;
         i += d;
     }
@@ -78,6 +109,52 @@ optional<size_t> utf8_char_pos(char const * str, size_t char_idx) {
     return optional<size_t>();
 }
 
+/* Size of the UTF-8 character starting with `c`, matching `lean_string_utf8_next` on invalid positions. */
+static inline unsigned utf8_next_size(unsigned char c) {
+    if ((c & 0x80) == 0)    return 1;
+    if ((c & 0xe0) == 0xc0) return 2;
+    if ((c & 0xf0) == 0xe0) return 3;
+    if ((c & 0xf8) == 0xf0) return 4;
+    return 1;
+}
+
+size_t utf8_next_n(char const * str, size_t size, size_t i, size_t & n) {
+    while (n > 0 && i < size) {
+        unsigned char c = str[i];
+        if (c < 0x80) {
+            size_t k = ascii_prefix_size(str + i, std::min(size - i, n));
+            if (k > 0) {
+                i += k;
+                n -= k;
+                continue;
+            }
+        }
+        i += utf8_next_size(c);
+        n--;
+    }
+    return i;
+}
+
+size_t utf8_count(char const * str, size_t size, size_t b, size_t e) {
+    size_t r = 0;
+    size_t i = b;
+    while (i != e && i < size) {
+        unsigned char c = str[i];
+        if (c < 0x80) {
+            /* Each ASCII character is a valid position, so we cannot skip `e` if we stop before it. */
+            size_t k = ascii_prefix_size(str + i, (i < e ? std::min(size, e) : size) - i);
+            if (k > 0) {
+                i += k;
+                r += k;
+                continue;
+            }
+        }
+        i += utf8_next_size(c);
+        r++;
+    }
+    return r;
+}
+
 char const * get_utf8_last_char(char const * str) {
     char const * r;
     lean_assert(*str != 0);
@@ -269,6 +346,14 @@ bool validate_utf8_one(uint8_t const * str, size_t size, size_t & pos) {
 
 bool validate_utf8(uint8_t const * str, size_t size, size_t & pos, size_t & i) {
     while (pos < size) {
+        if (str[pos] < 0x80) {
+            size_t n = ascii_prefix_size(reinterpret_cast<char const *>(str) + pos, size - pos);
+            if (n > 0) {
+                pos += n;
+                i   += n;
+                continue;
+            }
+        }
         if (!validate_utf8_one(str, size, pos)) return false;
         i++;
     }
@@ -24,6 +24,13 @@ LEAN_EXPORT size_t utf8_strlen(std::string const & str);
    `str` may contain null characters. */
 LEAN_EXPORT size_t utf8_strlen(char const * str, size_t sz);
 LEAN_EXPORT optional<size_t> utf8_char_pos(char const * str, size_t char_idx);
+/* Advance the byte position `i` in `str[0, size)` by `n` unicode scalar values, stopping at `size`.
+   `n` is decremented by the number of unicode scalar values skipped.
+   As in `String.next`, a position that is not the first byte of an UTF-8 character is advanced by one byte. */
+LEAN_EXPORT size_t utf8_next_n(char const * str, size_t size, size_t i, size_t & n);
+/* Return the number of unicode scalar values that must be skipped, starting at byte position `b` in
+   `str[0, size)`, to reach the byte position `e` or `size`. */
+LEAN_EXPORT size_t utf8_count(char const * str, size_t size, size_t b, size_t e);
 LEAN_EXPORT char const * get_utf8_last_char(char const * str);
 LEAN_EXPORT std::string utf8_trim(std::string const & s);
 LEAN_EXPORT unsigned utf8_to_unicode(uchar const * begin, uchar const * end);
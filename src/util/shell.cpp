@@ -736,6 +736,7 @@ extern "C" LEAN_EXPORT int lean_main(int argc, char ** argv) {
 
         if (run && ok) {
             uint32 ret = ir::run_main(env, opts, argc - optind, argv + optind);
+            ir::save_interpreter_profile();
             // environment_free_regions(std::move(env));
             return ret;
         }
@@ -751,7 +752,7 @@ extern "C" LEAN_EXPORT int lean_main(int argc, char ** argv) {
                 return 1;
             }
             time_task _("C code generation", opts);
-            out << lean::ir::emit_c(env, *main_module_name).data();
+            out << lean::ir::emit_c(env, *main_module_name, opts).data();
             out.close();
         }
 
@@ -766,6 +767,7 @@ extern "C" LEAN_EXPORT int lean_main(int argc, char ** argv) {
         }
 
         display_cumulative_profiling_times(std::cerr);
+        ir::save_interpreter_profile();
 
 #ifdef LEAN_SMALL_ALLOCATOR
         // If the small allocator is not enabled, then we assume we are not using the sanitizer.
@@ -0,0 +1,18 @@
+/-- Product of the numbers in `(lo, hi]`, using a balanced product tree. -/
+partial def prodRange (lo hi : Nat) : Nat :=
+  if hi - lo ≤ 16 then
+    (List.range (hi - lo)).foldl (fun acc i => acc * (lo + i + 1)) 1
+  else
+    let mid := (lo + hi) / 2
+    prodRange lo mid * prodRange mid hi
+
+def main : List String → IO Unit
+| [n] => do
+  let n := n.toNat!
+  let f := prodRange 0 n
+  let g := prodRange 0 (n / 2)
+  let q := f / g
+  IO.println (toString q).length
+  IO.println (q % 1000000007)
+  IO.println (f % g)
+| _ => throw $ IO.userError "give upper bound"
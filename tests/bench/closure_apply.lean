@@ -0,0 +1,38 @@
+/-!
+Applies closures through generic monadic code and higher-order list functions, both of which go
+through the runtime's `lean_apply_*` functions instead of direct calls.
+-/
+
+abbrev M := StateT Nat (ReaderT Nat (ExceptT String Id))
+
+@[nospecialize] def tick {m : Type → Type} [Monad m] [MonadStateOf Nat m] [MonadReaderOf Nat m] (i : Nat) : m Unit := do
+  let k ← readThe Nat
+  modifyThe Nat fun s => (s * 31 + k + i) % 1000007
+
+@[nospecialize] def ticks {m : Type → Type} [Monad m] [MonadStateOf Nat m] [MonadReaderOf Nat m] (n : Nat) : m Unit := do
+  for i in [0:n] do
+    tick i
+
+def runM (x : M Unit) (k s : Nat) : Nat :=
+  let r : Except String (Unit × Nat) := ((x.run s).run k).run
+  match r with
+  | .ok (_, s) => s
+  | .error _   => 0
+
+def step (k a b c d : Nat) : Nat := (a * k + b * 7 + c * 3 + d) % 1000007
+
+/-- Partial applications of `step` that are completed one argument at a time. -/
+def paps (k : Nat) (xs : List Nat) : Nat :=
+  let fs := xs.map (step k)
+  let gs := fs.map (· 3)
+  let hs := gs.map (· 5)
+  hs.foldl (fun acc h => (acc + h acc) % 1000007) 0
+
+def main : List String → IO Unit
+| [n] => do
+  let xs := List.range 1000
+  let mut total := 0
+  for i in [0:n.toNat!] do
+    total := (total + paps i xs + runM (ticks 1000) i total) % 1000007
+  IO.println total
+| _ => throw $ IO.userError "give number of iterations"
@@ -0,0 +1,26 @@
+/-!
+Arithmetic-heavy proofs and evaluation on `Int`s that do not fit in the 32-bit range of scalar `Int`s,
+such as the coefficients and constants `omega` manipulates.
+-/
+
+example (x y : Int) (h : 4000000000 * x + 6000000000 * y = 3000000001) : False := by omega
+
+example (x : Int) (h₁ : x ≥ 5000000000) (h₂ : 3 * x ≤ 15000000002) : x ≤ 5000000000 := by omega
+
+example (x y : Int) (h₁ : x + 1000000000000 * y ≤ 7) (h₂ : y ≥ 1) (h₃ : x ≥ -999999999992) : False := by omega
+
+example (x y z : Int) (h₁ : 3000000017 * x - 2000000011 * y + z = 12) (h₂ : 0 ≤ z) (h₃ : z < 1)
+    (h₄ : x = 2 * y) : y ≠ 1 := by omega
+
+example (n m : Nat) (h₁ : n + 8589934592 < m) (h₂ : m ≤ 8589934593) : n = 0 := by omega
+
+/-- Linear congruential generator over `Int`, with intermediate values larger than `2^32`. -/
+def lcg (n : Nat) : Int := Id.run do
+  let mut x : Int := 123456789
+  let mut acc : Int := 0
+  for _ in [0:n] do
+    x := (x * 1103515245 + 12345) % 4294967311
+    acc := acc + x / 65536 - Int.mod x 7
+  return acc
+
+#eval lcg 1000000
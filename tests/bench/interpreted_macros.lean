@@ -0,0 +1,75 @@
+import Lean
+/-!
+Macros, tactics, and `#eval`s defined in this file, which the IR interpreter runs as the file is
+elaborated: a macro computing its expansion with a recursive function, recursive `macro_rules`, a
+custom tactic, and a syntax tree transformation.
+-/
+
+open Lean Elab Tactic Meta
+
+/-- Naive Fibonacci, evaluated during macro expansion. -/
+def fibAux : Nat → Nat
+  | 0     => 0
+  | 1     => 1
+  | n + 2 => fibAux n + fibAux (n + 1)
+
+macro "fib% " n:num : term => return Syntax.mkNumLit (toString (fibAux n.getNat))
+
+example : fib% 25 = 75025 := rfl
+example : fib% 26 = 121393 := rfl
+
+/-- `sum% [a, b, ...]` expands to `a + (b + ...)`, one element per expansion step. -/
+syntax "sum% " "[" term,* "]" : term
+macro_rules
+  | `(sum% [ ]) => `(0)
+  | `(sum% [ $x ]) => `($x)
+  | `(sum% [ $x, $xs,* ]) => `($x + sum% [ $xs,* ])
+
+example : sum% [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+  21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40] = 820 := rfl
+
+/-- `conj% n` expands to `True ∧ ... ∧ True` with `n + 1` conjuncts. -/
+syntax "conj% " num : term
+macro_rules
+  | `(conj% $n) => do
+    let mut t : TSyntax `term ← `(True)
+    for _ in [0:n.getNat] do
+      t ← `(True ∧ $t)
+    return t
+
+/-- Split conjunctions with `And.intro` and close the remaining goals with `True.intro`. -/
+partial def splitAll (g : MVarId) : MetaM Unit := do
+  let t ← whnfR (← g.getType)
+  if t.isAppOfArity ``And 2 then
+    for g' in ← g.apply (mkConst ``And.intro) do
+      splitAll g'
+  else
+    g.assign (mkConst ``True.intro)
+
+elab "split_all" : tactic => liftMetaTactic fun g => do splitAll g; return []
+
+set_option maxRecDepth 4000 in
+example : conj% 300 := by split_all
+set_option maxRecDepth 4000 in
+example : conj% 300 := by split_all
+
+/-- Append `'` to every identifier of `stx`, rebuilding the tree like a macro expander does. -/
+partial def primeIdents (stx : Syntax) : Syntax :=
+  match stx with
+  | .ident info raw val pre => .ident info raw (val.appendAfter "'") pre
+  | .node info kind args    => .node info kind (args.map primeIdents)
+  | _                       => stx
+
+/-- A syntax tree of depth `d` whose inner nodes have four children: three subtrees and a `+` atom. -/
+def mkTree : Nat → Syntax
+  | 0     => mkIdent `x
+  | d + 1 => mkNullNode #[mkTree d, mkAtom "+", mkTree d, mkTree d]
+
+/-- Number of identifiers ending in `'` in `stx`. -/
+partial def countPrimed (stx : Syntax) : Nat :=
+  match stx with
+  | .ident _ _ val _ => if val.toString.endsWith "'" then 1 else 0
+  | .node _ _ args   => args.foldl (fun n a => n + countPrimed a) 0
+  | _                => 0
+
+#eval (List.range 20).foldl (fun n _ => n + countPrimed (primeIdents (mkTree 8))) 0
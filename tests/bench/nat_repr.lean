@@ -4,5 +4,12 @@ def main : List String → IO Unit
   for i in [0:n.toNat!] do
     for j in [:i] do
       s := s + j.repr.length
+  -- huge numbers, converted in both directions
+  for i in [0:20] do
+    let big := 7 ^ (50000 + i)
+    let str := big.repr
+    if str.toNat? != some big then
+      throw $ IO.userError "String.toNat? failed"
+    s := s + str.length
   IO.println s
 | _ => throw $ IO.userError "give upper bound"
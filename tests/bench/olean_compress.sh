@@ -0,0 +1,13 @@
+#!/usr/bin/env bash
+# Writes the module `olean_data`, which has many declarations, to `olean_plain/` and, with `LEAN_OLEAN_COMPRESS`, to
+# `olean_zstd/` for comparing import time and .olean size. Requires a build of Lean with `USE_ZSTD`.
+set -euo pipefail
+
+for i in $(seq 0 19999); do
+  echo "def d$i : String := \"value $i\""
+done > olean_data.lean
+echo "import olean_data" > olean_import.lean
+rm -rf olean_plain olean_zstd
+mkdir olean_plain olean_zstd
+lean --root=. -o olean_plain/olean_data.olean olean_data.lean
+LEAN_OLEAN_COMPRESS=${LEAN_OLEAN_COMPRESS:-3} lean --root=. -o olean_zstd/olean_data.olean olean_data.lean
@@ -0,0 +1,31 @@
+/-!
+Bulk `ByteArray` and `FloatArray` primitives: counting lines, XOR-ing buffers, and
+elementwise arithmetic and dot products of float vectors.
+-/
+
+def countLines (bs : ByteArray) : Nat := Id.run do
+  let mut n := 0
+  let mut i := 0
+  while true do
+    match bs.indexOf? 10 i with
+    | some j => n := n + 1; i := j + 1
+    | none   => break
+  return n
+
+def main : List String → IO Unit
+| [n] => do
+  let line := "theorem foo (xs : List Nat) : xs ++ [] = xs := by simp\n".toUTF8
+  let mut text := ByteArray.empty
+  for _ in [0:20000] do
+    text := text ++ line
+  let key := ByteArray.mk (Array.mkArray text.size 42)
+  let xs : FloatArray := ⟨(Array.range 1000000).map fun i => i.toFloat / 1000000⟩
+  let mut lines := 0
+  let mut acc : Float := 0
+  for _ in [0:n.toNat!] do
+    lines := lines + countLines text
+    text := (text.xor key).xor key
+    let ys := (xs.add xs).mul xs
+    acc := acc + xs.dot ys - 2 * (xs.mul xs).dot xs + ys.sum - 2 * (xs.mul xs).sum
+  IO.println s!"{lines} {acc.abs < 1}"
+| _ => throw $ IO.userError "give number of iterations"
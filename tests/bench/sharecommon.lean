@@ -0,0 +1,26 @@
+/-!
+Maximally shares large trees with `ShareCommon.shareCommon'`, which hashes the contents of every
+object it visits (see `lean_sharecommon_hash`).
+-/
+
+inductive Tree where
+  | leaf (s : String)
+  | node (l r : Tree) (tag : Nat)
+
+/-- A complete tree of depth `d`. Equal leaves and subtrees are built separately, so nothing is shared. -/
+def mkTree (i : Nat) : Nat → Tree
+  | 0     => .leaf s!"{i % 16}: a moderately long leaf label that spans more than one hash block"
+  | d + 1 => .node (mkTree (2 * i) d) (mkTree (2 * i + 1) d) (i % 4)
+
+def Tree.size : Tree → Nat
+  | .leaf _     => 1
+  | .node l r _ => l.size + r.size
+
+def main : List String → IO Unit
+| [n] => do
+  let mut total := 0
+  for i in [0:n.toNat!] do
+    let t := ShareCommon.shareCommon' (mkTree i 16)
+    total := total + t.size
+  IO.println total
+| _ => throw $ IO.userError "give number of iterations"
@@ -0,0 +1,29 @@
+/-!
+Produces a large amount of text from small pieces, in the style of the C emitter and `Format.pretty`.
+-/
+
+open Std
+
+/-- A C-like function body with `n` statements and nested blocks. -/
+def mkBody (n : Nat) : Format :=
+  let stmts := (List.range n).map fun i =>
+    if i % 10 == 0 then
+      Format.text s!"if (x_{i} != 0) " ++ Format.bracket "{" (Format.line ++ s!"x_{i+1} = lean_box({i});" ++ Format.line ++ "return x_0;") "}"
+    else
+      Format.text s!"lean_object* x_{i+1} = lean_ctor_get(x_{i}, {i % 4});"
+  Format.nest 2 (Format.joinSep stmts Format.line)
+
+def emitDecl (i : Nat) : String :=
+  let args := (List.range (i % 8)).map fun j => s!"lean_object* x_{j}"
+  "LEAN_EXPORT lean_object* l_f" ++ toString i ++ "(" ++ ", ".intercalate args ++ ") {\n" ++
+    (mkBody 40).pretty 100 ++ "\n}\n"
+
+def main : List String → IO Unit
+| [n] => do
+  let mut total := 0
+  for _ in [0:n.toNat!] do
+    let decls := (List.range 2000).map emitDecl
+    let out := String.join decls
+    total := total + out.length
+  IO.println total
+| _ => throw $ IO.userError "give number of iterations"
@@ -0,0 +1,19 @@
+/-!
+Validates and decodes UTF-8 text resembling Lean sources (mostly ASCII with some
+unicode symbols) and JSON-RPC messages.
+-/
+
+def leanLine := "theorem foo (xs : List Nat) : ∀ x ∈ xs, x + 0 = x := by simp [Nat.add_zero] -- ok\n"
+def jsonLine := "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":{\"version\":1,\"text\":\"λ x ↦ x\"}}\n"
+
+def main : List String → IO Unit
+| [n] => do
+  let inputs := [leanLine, jsonLine].map fun line => (String.join (List.replicate 10000 line)).toUTF8
+  let mut total := 0
+  for _ in [0:n.toNat!] do
+    for bytes in inputs do
+      match String.fromUTF8? bytes with
+      | some s => total := total + s.length
+      | none   => throw $ IO.userError "invalid UTF-8"
+  IO.println total
+| _ => throw $ IO.userError "give number of iterations"
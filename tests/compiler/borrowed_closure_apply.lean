@@ -0,0 +1,16 @@
+@[noinline] def applyAll (f : Nat → Nat → String) : List Nat → List String
+  | []      => []
+  | x :: xs => f x (x + 1) :: applyAll f xs
+
+@[noinline] def twice (f : String → String) (s : String) : String :=
+  f (f s)
+
+@[noinline] def mkPrefix (n : Nat) : String :=
+  "p" ++ toString n
+
+def main : IO Unit := do
+  let pre := mkPrefix 1
+  IO.println (applyAll (fun a b => pre ++ toString (a + b)) [1, 2, 3])
+  let g : Nat → Nat → Nat → String := fun a b c => s!"{pre}{a}{b}{c}"
+  IO.println (applyAll (g 7) [4, 5])
+  IO.println (twice (· ++ pre) "s")
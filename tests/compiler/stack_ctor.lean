@@ -0,0 +1,56 @@
+/-!
+Constructor objects that do not escape their function and are allocated on the C stack (see
+`Lean.IR.EscapeAnalysis`): in a loop compiled to `goto _start`, in a join point, in a case arm, with
+scalar fields, and with projections used after the object is released.
+-/
+
+structure Sample where
+  name  : String
+  count : Nat
+  total : UInt64
+  index : USize
+  ok    : Bool
+
+@[noinline] def mkName (n : Nat) : String :=
+  "s" ++ toString n
+
+/-- A pair built and released in every iteration; the storage is reused after `goto _start`. -/
+partial def sumPairs (i n acc : Nat) : Nat :=
+  if i < n then
+    let p := (i, i * i)
+    sumPairs (i + 1) n (acc + p.1 + p.2)
+  else
+    acc
+
+/-- The pair is built in the join point after the `if`. -/
+@[noinline] def inJoinPoint (b : Bool) (n : Nat) : String :=
+  let m := if b then n + 1 else n * 2
+  let p := (mkName m, m)
+  p.1 ++ ":" ++ toString p.2
+
+@[noinline] def inCaseArm : Option Nat → String
+  | some n => let p := (mkName n, n + 1); p.1 ++ "/" ++ toString p.2
+  | none   => "none"
+
+/-- Scalar fields are written with `sset`/`uset` into the stack storage. -/
+@[noinline] def scalarFields (n : Nat) : String :=
+  let s : Sample := { name := mkName n, count := n, total := n.toUInt64 * 3, index := n.toUSize + 1, ok := n % 2 == 0 }
+  s!"{s.name} {s.count} {s.total} {s.index} {s.ok}"
+
+/-- The fields outlive the pair. -/
+@[noinline] def projAfterDec (a b : String) : String :=
+  let p := (a ++ "!", b ++ "?")
+  let x := p.1
+  let y := p.2
+  y ++ x
+
+def main : IO Unit := do
+  IO.println (sumPairs 0 5 0)
+  IO.println (sumPairs 0 1000 0)
+  IO.println (inJoinPoint true 3)
+  IO.println (inJoinPoint false 3)
+  IO.println (inCaseArm (some 2))
+  IO.println (inCaseArm none)
+  IO.println (scalarFields 5)
+  IO.println (scalarFields 8)
+  IO.println (projAfterDec "a" "b")
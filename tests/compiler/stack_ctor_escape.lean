@@ -0,0 +1,31 @@
+/-!
+Constructor objects that escape their function through `ret`, `jmp`, an application, or another
+constructor must stay on the heap (see `Lean.IR.EscapeAnalysis`).
+-/
+
+@[noinline] def mkName (n : Nat) : String :=
+  "e" ++ toString n
+
+@[noinline] def viaRet (n : Nat) : String × Nat :=
+  (mkName n, n)
+
+/-- The pairs are passed to the join point after the `if`. -/
+@[noinline] def viaJmp (b : Bool) (n : Nat) : String :=
+  let p := if b then (mkName n, n) else (mkName (n + 1), n + 2)
+  p.1 ++ "-" ++ toString p.2
+
+@[noinline] def render (p : String × Nat) : String :=
+  p.1 ++ "=" ++ toString p.2
+
+@[noinline] def viaApp (n : Nat) : String :=
+  render (mkName n, n * 10)
+
+@[noinline] def viaCtor (n : Nat) : List (String × Nat) :=
+  [(mkName n, n), (mkName (n + 1), n + 1)]
+
+def main : IO Unit := do
+  IO.println (viaRet 3)
+  IO.println (viaJmp true 1)
+  IO.println (viaJmp false 1)
+  IO.println (viaApp 4)
+  IO.println (viaCtor 7)
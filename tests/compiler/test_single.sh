@@ -1,6 +1,9 @@
 #!/usr/bin/env bash
 source ../common.sh
 
+# `$f.opts` holds additional options for compiling `$f` to C
+[ -f "$f.opts" ] && LEAN_OPTS="$(< "$f.opts")"
+
 # First check the C version actually works...
 echo "running C program..."
 rm "./$f.out" || true
@@ -0,0 +1,19 @@
+@[noinline] def divMod (a b : Nat) : Nat × Nat :=
+  (a / b, a % b)
+
+@[noinline] def fib : Nat → Nat × Nat
+  | 0     => (0, 1)
+  | n + 1 => let (a, b) := fib n; (b, a + b)
+
+@[noinline] def minMax (xs : List Nat) (lo hi : Nat) : Nat × Nat × String :=
+  match xs with
+  | []      => (lo, hi, "done")
+  | x :: xs => minMax xs (min lo x) (max hi x)
+
+def main : IO Unit := do
+  let (q, r) := divMod 17 5
+  IO.println s!"{q} {r}"
+  IO.println (fib 90).1
+  let (lo, hi, s) := minMax [3, 1, 4, 1, 5, 9, 2, 6] 100 0
+  IO.println s!"{lo} {hi} {s}"
+  IO.println ([10, 11, 12].map (divMod · 4))
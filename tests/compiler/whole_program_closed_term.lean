@@ -0,0 +1,9 @@
+/-!
+`String.toNat!` and `String.removeLeadingSpaces` use closed terms of `Init.Data.String.Extra`,
+which are `static` in the C file of that module. With `compiler.wholeProgram` set (see
+`whole_program_closed_term.lean.opts`), they must not be copied into this module.
+-/
+
+def main : IO Unit := do
+  IO.println ("12345".toNat! + 1)
+  IO.println ("  a\n    b\n  c".removeLeadingSpaces)
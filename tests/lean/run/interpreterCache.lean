@@ -0,0 +1,30 @@
+/-!
+Interpreters of different commands share the cache of imported declarations (see `Lean.IR.InterpreterCache`). With
+`interpreter.prefer_native` unset, imported functions and closed constants are interpreted, so evaluating them a second
+time uses their cached code and constant values.
+-/
+
+set_option interpreter.prefer_native false
+
+def sumDoubled (n : Nat) : Nat :=
+  ((List.range n).map (· * 2)).foldl (· + ·) 0
+
+#guard sumDoubled 10 == 90
+#guard sumDoubled 10 == 90
+#guard (List.iota 5).toString == "[5, 4, 3, 2, 1]"
+#guard (List.iota 5).toString == "[5, 4, 3, 2, 1]"
+#guard Nat.toSuperscriptString 123 == "¹²³"
+#guard Nat.toSuperscriptString 123 == "¹²³"
+#guard "a,b,,c".splitOn "," == ["a", "b", "", "c"]
+#guard "a,b,,c".splitOn "," == ["a", "b", "", "c"]
+
+/-- info: #[0, 1, 4, 9] -/
+#guard_msgs in
+#eval (Array.range 4).map (· ^ 2)
+
+/-- info: #[0, 1, 4, 9] -/
+#guard_msgs in
+#eval (Array.range 4).map (· ^ 2)
+
+set_option interpreter.prefer_native true in
+#guard sumDoubled 10 == 90
@@ -0,0 +1,28 @@
+/-!
+`interpreter.jit_threshold` only compiles imported functions without native code (see
+`tests/pkg/jit`). Functions of the current module and imported functions with native code must keep
+working through the interpreter and the native code, respectively.
+-/
+
+set_option interpreter.jit_threshold 1
+
+def fib : Nat → Nat
+  | 0     => 0
+  | 1     => 1
+  | n + 2 => fib n + fib (n + 1)
+
+def sumTo (n : Nat) : Nat :=
+  (List.range (n + 1)).foldl (· + ·) 0
+
+partial def loop (n acc : Nat) : Nat :=
+  if n == 0 then acc else loop (n - 1) (acc + n)
+
+#guard fib 20 == 6765
+#guard fib 20 == 6765
+#guard loop 100 0 == 5050
+#guard loop 1000 0 == 500500
+#guard sumTo 100 == 5050
+#guard (List.range 8).map fib == [0, 1, 1, 2, 3, 5, 8, 13]
+
+set_option interpreter.prefer_native false in
+#guard (List.range 8).map fib == [0, 1, 1, 2, 3, 5, 8, 13]
@@ -0,0 +1,15 @@
+#guard (0 : Nat).toDecimalString == "0"
+#guard (1234567890123456789 : Nat).toDecimalString == "1234567890123456789"
+#guard (2^200).toDecimalString == (Nat.toDigits 10 (2^200)).asString
+#guard (0 : Nat).toHexString == "0"
+#guard (255 : Nat).toHexString == "ff"
+#guard (2^200 + 0xabc).toHexString == (Nat.toDigits 16 (2^200 + 0xabc)).asString
+#guard (0x1f : BitVec 16).toHex == "001f"
+
+#guard "".toNat? == none
+#guard "12a".toNat? == none
+#guard "-1".toNat? == none
+#guard "007".toNat? == some 7
+#guard "18446744073709551616".toNat? == some (2^64)
+#guard ((3^1000).repr ++ "0").toNat? == some (3^1000 * 10)
+#guard (List.range 50).all fun i => (7^(i*20)).repr.toNat? == some (7^(i*20))
@@ -0,0 +1,25 @@
+def test : IO Unit := do
+  let tmpFile := "readToEnd.tmp"
+  let content := String.join ((List.range 2000).map fun i => s!"line {i}: λ€😀\n")
+  IO.FS.writeFile tmpFile content
+  let s ← IO.FS.readFile tmpFile
+  assert! s == content && s.length == content.length
+  let b ← IO.FS.readBinFile tmpFile
+  assert! b == content.toUTF8
+  let handle ← IO.FS.Handle.mk tmpFile .read
+  let firstLine ← handle.getLine
+  let rest ← handle.readToEnd
+  assert! firstLine ++ rest == content
+  assert! (← handle.readBinToEnd).isEmpty
+  IO.FS.writeBinFile tmpFile ⟨#[0x61, 0xff]⟩
+  let r ← (IO.FS.readFile tmpFile).toBaseIO
+  assert! r matches .error _
+  assert! (← IO.FS.readBinFile tmpFile) == ⟨#[0x61, 0xff]⟩
+  IO.FS.writeFile tmpFile ""
+  assert! (← IO.FS.readFile tmpFile) == ""
+  IO.FS.removeFile tmpFile
+  IO.println "ok"
+
+/-- info: ok -/
+#guard_msgs in
+#eval test
@@ -0,0 +1,23 @@
+def bytes : ByteArray := "hello world\nfoo\nbar".toUTF8
+
+#guard bytes.indexOf? '\n'.toNat.toUInt8 == some 11
+#guard bytes.indexOf? '\n'.toNat.toUInt8 12 == some 15
+#guard bytes.indexOf? 'z'.toNat.toUInt8 == none
+#guard bytes.indexOf? 'h'.toNat.toUInt8 100 == none
+#guard bytes == "hello world\nfoo\nbar".toUTF8
+#guard bytes != "hello world\nfoo\nbaz".toUTF8
+#guard bytes != "hello".toUTF8
+#guard (bytes.fill 0 6 5).toList == (ByteArray.mk (bytes.data.mapIdx fun i x => if 6 ≤ i.1 ∧ i.1 < 11 then 0 else x)).toList
+#guard bytes.fill 120 17 100 == "hello world\nfoo\nbxx".toUTF8
+#guard bytes.fill 120 100 1 == bytes
+#guard (bytes.xor ⟨#[1, 2]⟩) == "igllo world\nfoo\nbar".toUTF8
+#guard (bytes.xor bytes).toList.all (· == 0)
+
+def fs : FloatArray := ⟨#[1, 2, 3]⟩
+def gs : FloatArray := ⟨#[10, 20]⟩
+
+#guard fs.sum == 6
+#guard fs.dot gs == 50
+#guard (fs.add gs).toList == [11, 22, 3]
+#guard (fs.mul gs).toList == [10, 40, 3]
+#guard (gs.mul fs).toList == [10, 40]
@@ -0,0 +1,58 @@
+import Lean.Util.ShareCommon
+
+open Lean.ShareCommon
+def check (b : Bool) : IO Unit := do
+  unless b do throw $ IO.userError "check failed"
+
+@[noinline] def mkList (i n : Nat) : List Nat :=
+  List.replicate i 0 ++ (List.range n).map (· + 1)
+
+unsafe def tst1 : IO Unit := do
+  let t ← Table.new
+  let tasks ← (List.range 8).mapM fun i => IO.asTask (t.shareCommon (mkList i 100))
+  let rs ← tasks.mapM fun task => IO.ofExcept task.get
+  let r ← t.shareCommon (mkList 0 100)
+  for (i, r') in (List.range 8).zip rs do
+    check $ ptrAddrUnsafe (r'.drop i) == ptrAddrUnsafe r
+  check $ r == mkList 0 100
+  IO.println (← t.size)
+
+/-- info: 107 -/
+#guard_msgs in
+#eval tst1
+
+def tst2 : IO Unit := do
+  let t ← Table.new
+  discard <| t.shareCommon (mkList 3 10)
+  IO.println (← t.size)
+  IO.println (← t.prune)
+  IO.println (← t.size)
+
+/--
+info: 13
+13
+0
+-/
+#guard_msgs in
+#eval tst2
+
+/-- Pruning a deep term frees its entries level by level. -/
+def tst3 (n : Nat) : IO Unit := do
+  let t ← Table.new
+  let r ← t.shareCommon (mkList 0 n)
+  let tail := r.drop (n / 2)
+  IO.println (← t.size)
+  IO.println (← t.prune)
+  IO.println tail.length
+  IO.println (← t.prune)
+  IO.println (← t.size)
+
+/--
+info: 20000
+10000
+10000
+10000
+0
+-/
+#guard_msgs in
+#eval tst3 20000
@@ -0,0 +1,13 @@
+#guard String.join [] == ""
+#guard String.join ["abc"] == "abc"
+#guard String.join ["ab", "", "λx", "€"] == "abλx€"
+#guard (String.join ["ab", "", "λx", "€"]).length == 5
+#guard ", ".intercalate [] == ""
+#guard ", ".intercalate ["a"] == "a"
+#guard ", ".intercalate ["a", "", "λ"] == "a, , λ"
+#guard "".intercalate ["a", "b"] == "ab"
+#guard "x".pushn ' ' 3 == "x   "
+#guard ("x".pushn 'λ' 2).length == 3
+#guard "".pushn '😀' 2 == "😀😀"
+#guard "a".pushn 'b' 0 == "a"
+#guard (Std.Format.nest 2 ("a" ++ Std.Format.line ++ "b")).pretty 0 == "a\n  b"
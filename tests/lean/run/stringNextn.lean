@@ -0,0 +1,21 @@
+import Lean.Data.Position
+
+def s := "L∃∀N abcdefghijklmnopqrstuvwxyz 𝔸𝔹ℂ 0123456789"
+
+def iterNextn (p : String.Pos) (n : Nat) : String.Pos :=
+  (String.Iterator.nextn ⟨s, p⟩ n).pos
+
+#guard (List.range 60).all fun n => s.nextn 0 n == iterNextn 0 n
+#guard (List.range 60).all fun n => s.nextn ⟨1⟩ n == iterNextn ⟨1⟩ n
+#guard s.nextn ⟨2⟩ 1 == ⟨3⟩
+#guard s.nextn s.endPos 3 == s.endPos + ⟨3⟩
+#guard s.nextn 0 (2^100) == s.endPos + ⟨2^100 - s.length⟩
+
+#guard s.countChars 0 s.endPos == s.length
+#guard (List.range 60).all fun n => s.countChars 0 (s.nextn 0 n) == min n s.length
+#guard s.countChars ⟨5⟩ ⟨1⟩ == (s.extract ⟨7⟩ s.endPos).length + 2
+#guard s.countChars ⟨2⟩ s.endPos == (s.extract ⟨4⟩ s.endPos).length + 2
+#guard s.countChars 0 ⟨2^100⟩ == s.length
+
+#guard ("a\nbé∀c\n".toFileMap.toPosition ⟨8⟩) == ⟨2, 3⟩
+#guard ("a\nbé∀c\n".toFileMap.ofPosition ⟨2, 3⟩) == ⟨8⟩
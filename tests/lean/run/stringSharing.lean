@@ -0,0 +1,34 @@
+/-!
+Appending the empty string and extracting a whole string return an existing string object instead of a copy.
+-/
+
+@[noinline] def mkStr (n : Nat) : String := String.mk (List.replicate n 'a')
+@[noinline] def app (s t : String) : String := s ++ t
+@[noinline] def ext (s : String) (b e : String.Pos) : String := s.extract b e
+
+/-- info: true -/
+#guard_msgs in
+#eval let s := mkStr 3; unsafe ptrEq (app s "") s
+
+/-- info: true -/
+#guard_msgs in
+#eval let s := mkStr 3; unsafe ptrEq (app "" s) s
+
+/-- info: true -/
+#guard_msgs in
+#eval let s := mkStr 3; unsafe ptrEq (ext s 0 s.endPos) s
+
+/-- info: true -/
+#guard_msgs in
+#eval let s := mkStr 3; unsafe ptrEq (ext s 0 ⟨10⟩) s
+
+/-- info: false -/
+#guard_msgs in
+#eval let s := mkStr 3; unsafe ptrEq (ext s 0 ⟨2⟩) s
+
+/-- info: false -/
+#guard_msgs in
+#eval let s := mkStr 3; unsafe ptrEq (app s "b") s
+
+#guard app (mkStr 2) "" == "aa" && app "" (mkStr 2) == "aa" && app (mkStr 2) "b" == "aab"
+#guard ext (mkStr 3) 0 ⟨3⟩ == "aaa" && ext (mkStr 3) ⟨1⟩ ⟨3⟩ == "aa"
@@ -0,0 +1,47 @@
+import Lean.Data.Lsp
+open IO Lean Lsp
+
+/-! `interpreter.profile` is written both by `lean` and by file workers, which end via `IO.Process.exit`. -/
+
+def profileFile : System.FilePath := "interpreter_profile.produced"
+
+def text : String := s!"set_option interpreter.profile \"{profileFile}\"
+def profiledFib : Nat → Nat
+  | 0 => 0
+  | 1 => 1
+  | n + 2 => profiledFib n + profiledFib (n + 1)
+#eval profiledFib 20
+"
+
+def checkProfile : IO Unit := do
+  let alloc := profileFile.toString ++ ".alloc"
+  unless (← profileFile.pathExists) && (← System.FilePath.pathExists alloc) do
+    throw <| userError s!"no interpreter profile written to '{profileFile}'"
+  unless ((← FS.readFile profileFile).splitOn "profiledFib").length > 1 do
+    throw <| userError s!"'{profileFile}' does not mention `profiledFib`"
+  FS.removeFile profileFile
+  FS.removeFile alloc
+
+def main : IO Unit := do
+  let file : System.FilePath := "interpreter_profile.produced.lean"
+  FS.writeFile file text
+  let out ← Process.output { cmd := (← IO.appPath).toString, args := #[file.toString] }
+  FS.removeFile file
+  unless out.exitCode == 0 do
+    throw <| userError s!"lean failed: {out.stdout}{out.stderr}"
+  checkProfile
+
+  Ipc.runWith (←IO.appPath) #["--worker"] do
+    let hIn ← Ipc.stdin
+    hIn.write (←FS.readBinFile "init_vscode_1_47_2.log")
+    hIn.flush
+
+    let uri := "file:///interpreter_profile"
+    Ipc.writeNotification ⟨"textDocument/didOpen", {
+      textDocument := { uri := uri, languageId := "lean", version := 1, text := text } : DidOpenTextDocumentParams }⟩
+    let diags? ← Ipc.collectDiagnostics 1 uri 1
+    assert! diags?.isSome
+
+    Ipc.writeNotification ⟨"exit", Json.null⟩
+    discard Ipc.waitForExit
+  checkProfile
@@ -0,0 +1,36 @@
+import Jit.Basic
+
+/-!
+With `interpreter.jit_threshold` set, builds with LLVM support compile the imported functions of
+`Jit.Basic`, which have no native code, once they have been called twice. Other builds keep
+interpreting them. Each function is checked both before and after it reaches the threshold.
+`addBase` uses an `[init]` declaration and `twice` is defined in this module, so both fall back to
+the interpreter.
+-/
+
+set_option interpreter.jit_threshold 2
+
+def twice (n : Nat) : Nat :=
+  fib n + fib n
+
+#guard fib 20 == 6765
+#guard fib 25 == 75025
+#guard countDown 10 0 == 55
+#guard countDown 100 0 == 5050
+#guard countDown 1000 0 == 500500
+#guard lookup 3 == 5
+#guard lookup 3 == 5
+#guard lookup 10 == 0
+#guard sumSquares [1, 2, 3] == 14
+#guard sumSquares (List.range 10) == 285
+#guard label 7 == "n=7"
+#guard label 8 == "n=8"
+#guard label 9 == "n=9"
+#guard scale 2.0 == 5.0
+#guard scale 4.0 == 10.0
+#guard scale 4.0 == 10.0
+#guard addBase 1 == 101
+#guard addBase 2 == 102
+#guard addBase 3 == 103
+#guard twice 10 == 110
+#guard twice 10 == 110
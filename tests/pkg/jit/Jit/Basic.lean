@@ -0,0 +1,30 @@
+/-! Functions that `Jit.lean` imports without native code, so that the interpreter evaluates them. -/
+
+def fib : Nat → Nat
+  | 0     => 0
+  | 1     => 1
+  | n + 2 => fib n + fib (n + 1)
+
+/-- Tail recursive, so the interpreter runs its recursive call as a jump. -/
+partial def countDown (n acc : Nat) : Nat :=
+  if n == 0 then acc else countDown (n - 1) (acc + n)
+
+def table : Array Nat := #[1, 2, 3, 5, 8]
+
+def lookup (i : Nat) : Nat :=
+  table[i]?.getD 0
+
+def sumSquares (xs : List Nat) : Nat :=
+  xs.foldl (fun acc x => acc + x * x) 0
+
+def label (n : Nat) : String :=
+  "n=" ++ toString n
+
+def scale (x : Float) : Float :=
+  x * 2.5
+
+initialize base : Nat ← pure 100
+
+/-- Uses an `[init]` declaration, so it is never compiled. -/
+def addBase (n : Nat) : Nat :=
+  n + base
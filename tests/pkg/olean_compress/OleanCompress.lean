@@ -0,0 +1,9 @@
+import OleanCompress.Data
+
+/-! Checks the declarations of `OleanCompress.Data`, which `test.sh` writes to a compressed .olean file. -/
+
+#guard d0 == "value 0"
+#guard d1234 == "value 1234"
+#guard d3999 == "value 3999"
+#guard table[999]! == 2997
+#guard table.size == 1000
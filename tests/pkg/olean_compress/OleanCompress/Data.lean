@@ -0,0 +1,13 @@
+import Lean
+
+/-! Enough declarations for the .olean file to span several compressed blocks. -/
+
+open Lean Elab Command in
+elab "gen_defs " n:num : command => do
+  for i in [0:n.getNat] do
+    let name := mkIdent (.mkSimple s!"d{i}")
+    elabCommand (← `(def $name : String := $(Syntax.mkStrLit s!"value {i}")))
+
+gen_defs 4000
+
+def table : Array Nat := (List.range 1000).toArray.map (· * 3)
@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+olean=.lake/build/lib/OleanCompress/Data.olean
+
+rm -rf .lake/build
+lake build
+plain_size=$(wc -c < $olean)
+
+# Write all .olean files compressed (see `LEAN_OLEAN_COMPRESS`), which the root module then imports.
+rm -rf .lake/build
+if ! out=$(LEAN_OLEAN_COMPRESS=3 lake build 2>&1); then
+  if grep -q "compressed .olean files are not supported by this build of Lean" <<< "$out"; then
+    echo "skipped: Lean was built without USE_ZSTD"
+    exit 0
+  fi
+  echo "$out"
+  exit 1
+fi
+compressed_size=$(wc -c < $olean)
+echo "$olean: $plain_size bytes, $compressed_size bytes compressed"
+[ "$compressed_size" -lt "$plain_size" ]
+
+# Reading the compressed files does not depend on the variable.
+lake env lean OleanCompress.lean
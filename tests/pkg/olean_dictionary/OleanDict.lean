@@ -0,0 +1,12 @@
+import OleanDict.A
+import OleanDict.B
+
+/-! Checks the declarations of `OleanDict.A` and `OleanDict.B`, which `test.sh` writes against a shared object dictionary. -/
+
+#guard sumSquares [1, 2, 3] == 14
+#guard sumCubes [1, 2, 3] == 36
+#guard labels [1, 2] == ["x=1", "x=2"]
+#guard tags [3] == ["t=3"]
+#guard (Point.mk 2 3).norm1 == 5
+#guard (Segment.mk 2 7).length == 5
+#guard Point.mk 1 2 == Point.mk 1 2
@@ -0,0 +1,15 @@
+/-! Declarations that share many names with `OleanDict.B`. -/
+
+def sumSquares (xs : List Nat) : Nat :=
+  (xs.map fun x => x * x).foldl (· + ·) 0
+
+def labels (xs : List Nat) : List String :=
+  xs.map fun x => s!"x={x}"
+
+structure Point where
+  x : Nat
+  y : Nat
+  deriving Repr, BEq
+
+def Point.norm1 (p : Point) : Nat :=
+  p.x + p.y
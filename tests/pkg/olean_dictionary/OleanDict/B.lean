@@ -0,0 +1,15 @@
+/-! Declarations that share many names with `OleanDict.A`. -/
+
+def sumCubes (xs : List Nat) : Nat :=
+  (xs.map fun x => x * x * x).foldl (· + ·) 0
+
+def tags (xs : List Nat) : List String :=
+  xs.map fun x => s!"t={x}"
+
+structure Segment where
+  a : Nat
+  b : Nat
+  deriving Repr, BEq
+
+def Segment.length (s : Segment) : Nat :=
+  s.b - s.a
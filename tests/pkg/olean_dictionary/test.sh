@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+rm -rf .lake/build dict.olean
+lake build
+plain_size=$(cat .lake/build/lib/OleanDict/*.olean | wc -c)
+
+# Build a dictionary of the names shared by the modules, then write them against it (see `LEAN_OLEAN_DICTIONARY`).
+lean --run ../../../script/mkOleanDictionary.lean dict.olean .lake/build/lib/OleanDict/*.olean
+export LEAN_OLEAN_DICTIONARY="$PWD/dict.olean"
+rm -rf .lake/build
+lake build
+dict_size=$(cat .lake/build/lib/OleanDict/*.olean | wc -c)
+echo "OleanDict/*.olean: $plain_size bytes, $dict_size bytes with dictionary"
+[ "$dict_size" -lt "$plain_size" ]
+
+# Importing them requires the same dictionary.
+lake env lean OleanDict.lean
+if out=$(LEAN_OLEAN_DICTIONARY= lake env lean OleanDict.lean 2>&1); then
+  echo "importing without the dictionary succeeded"
+  exit 1
+fi
+grep -q "references a shared object dictionary but \`LEAN_OLEAN_DICTIONARY\` is not set" <<< "$out"